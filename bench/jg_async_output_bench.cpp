@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <ostream>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
+#include "jg_async_output.h"
+#include "jg_diagram.h"
+
+// Exports a large diagram as SVG to a file and to a pipe that is drained slowly, once through a
+// plain buffered stream that writes on the serializing thread and once through async_fd_ostream,
+// which overlaps serialization with the writes. POSIX only.
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+// The synchronous baseline: the same buffer size as async_fd_streambuf, written in place.
+class fd_streambuf final : public std::streambuf
+{
+public:
+    explicit fd_streambuf(int fd, size_t buffer_size = 64 * 1024)
+        : m_fd{fd}
+        , m_buffer(buffer_size)
+    {
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (sync() != 0)
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        for (const char* data = pbase(); data < pptr();)
+        {
+            const auto written = write(m_fd, data, static_cast<size_t>(pptr() - data));
+
+            if (written <= 0)
+                return -1;
+
+            data += written;
+        }
+
+        setp(m_buffer.data(), m_buffer.data() + m_buffer.size());
+        return 0;
+    }
+
+private:
+    int m_fd;
+    std::vector<char> m_buffer;
+};
+
+jg::diagram large_diagram()
+{
+    jg::diagram diagram{"bench"};
+    std::vector<jg::item_id> ids;
+
+    for (int y = 0; y < 200; ++y)
+    {
+        for (int x = 0; x < 100; ++x)
+        {
+            const jg::rect bounds{50 + static_cast<float>(x) * 200, 50 + static_cast<float>(y) * 150, 100 + static_cast<float>(x % 7), 60};
+            ids.push_back(diagram.add_item(jg::rectangle{bounds, "item " + std::to_string(ids.size())}));
+
+            if (x > 0)
+                diagram.add_item(jg::line{ids[ids.size() - 2], ids.back(), jg::line_kind::filled_arrow});
+        }
+    }
+
+    return diagram;
+}
+
+double export_to(int fd, bool async, const jg::diagram& diagram)
+{
+    const auto start = clock_type::now();
+    bool ok;
+
+    if (async)
+    {
+        jg::async_fd_ostream stream{fd};
+        diagram.write_svg(stream);
+        stream.flush();
+        ok = static_cast<bool>(stream);
+    }
+    else
+    {
+        fd_streambuf buffer{fd};
+        std::ostream stream{&buffer};
+        diagram.write_svg(stream);
+        stream.flush();
+        ok = static_cast<bool>(stream);
+    }
+
+    if (!ok)
+    {
+        std::fprintf(stderr, "export failed\n");
+        std::exit(1);
+    }
+
+    return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+// Runs the export a few times and reports the best time.
+void measure(const char* name, size_t bytes, const std::function<double()>& run)
+{
+    double best = 1e9;
+
+    for (int i = 0; i < 3; ++i)
+        best = std::min(best, run());
+
+    std::printf("%-28s %8.1f ms  %7.1f MB/s\n", name, best * 1e3, static_cast<double>(bytes) / best / 1e6);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : "jg_async_output_bench.svg";
+    const auto diagram = large_diagram();
+
+    const auto serialize_start = clock_type::now();
+    std::ostringstream memory;
+    diagram.write_svg(memory);
+    const std::chrono::duration<double> serialize = clock_type::now() - serialize_start;
+    const size_t bytes = memory.str().size();
+
+    std::printf("hardware threads: %u, export: %.1f MB\n", std::thread::hardware_concurrency(), static_cast<double>(bytes) / 1e6);
+    std::printf("%-28s %8.1f ms\n", "serialize to memory", serialize.count() * 1e3);
+
+    for (const bool async : {false, true})
+    {
+        measure(async ? "file, async" : "file, sync", bytes, [&]
+        {
+            const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            const double seconds = export_to(fd, async, diagram);
+            close(fd);
+            return seconds;
+        });
+    }
+
+    // A reader that takes 64 KiB every millisecond, like a consumer on the other end of a pipe
+    // that can't keep up with the writer.
+    for (const bool async : {false, true})
+    {
+        measure(async ? "slow pipe, async" : "slow pipe, sync", bytes, [&]
+        {
+            int fds[2];
+
+            if (pipe(fds) != 0)
+                std::exit(1);
+
+            std::thread reader{[fd = fds[0]]
+            {
+                std::vector<char> data(64 * 1024);
+
+                while (read(fd, data.data(), data.size()) > 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds{1});
+
+                close(fd);
+            }};
+
+            const double seconds = export_to(fds[1], async, diagram);
+            close(fds[1]);
+            reader.join();
+            return seconds;
+        });
+    }
+
+    unlink(path);
+}
@@ -0,0 +1,86 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include <vector>
+#include "jg_diagram_builder.h"
+
+namespace
+{
+
+constexpr size_t item_count = 1000000;
+
+jg::rectangle shape(size_t index)
+{
+    return {{static_cast<float>(index % 1000) * 150, static_cast<float>(index / 1000) * 100, 100, 50}, "item"};
+}
+
+} // namespace
+
+// Adds the same number of shapes, each with a line to the previous one, from a growing number of
+// threads. The throughput is for adding everything and merging it with build(), which is what it
+// takes to get a diagram; the two parts are also reported on their own.
+int main()
+{
+    const unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::printf("hardware threads: %u\n", max_threads);
+
+    {
+        const auto start = std::chrono::steady_clock::now();
+        jg::diagram diagram{"bench"};
+        jg::item_id previous{};
+
+        for (size_t i = 0; i < item_count; ++i)
+        {
+            const auto id = diagram.add_item(shape(i));
+
+            if (previous != jg::item_id{})
+                diagram.add_item(jg::line{previous, id, jg::line_kind::filled_arrow});
+
+            previous = id;
+        }
+
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        std::printf("diagram::add_item:     %8.1f ms  %6.2f M items/s\n", elapsed.count() * 1e3, item_count / elapsed.count() / 1e6);
+    }
+
+    for (unsigned threads = 1; threads <= std::max(max_threads, 8u); threads *= 2)
+    {
+        jg::diagram_builder builder{"bench", threads};
+        const auto start = std::chrono::steady_clock::now();
+
+        std::vector<std::thread> producers;
+
+        for (unsigned t = 0; t < threads; ++t)
+        {
+            producers.emplace_back([&, t]
+            {
+                auto& shard = builder.get_shard(t);
+                jg::item_id previous{};
+
+                for (size_t i = t; i < item_count; i += threads)
+                {
+                    const auto id = shard.add_item(shape(i));
+
+                    if (previous != jg::item_id{})
+                        shard.add_item(jg::line{previous, id, jg::line_kind::filled_arrow});
+
+                    previous = id;
+                }
+            });
+        }
+
+        for (auto& producer : producers)
+            producer.join();
+
+        const auto added = std::chrono::steady_clock::now();
+        const auto diagram = builder.build();
+        const auto built = std::chrono::steady_clock::now();
+
+        const std::chrono::duration<double> add_time = added - start;
+        const std::chrono::duration<double> build_time = built - added;
+        const std::chrono::duration<double> total_time = built - start;
+        std::printf("builder %2u thread(s): %8.1f ms  %6.2f M items/s  (add %8.1f ms, build %8.1f ms)\n",
+                    threads, total_time.count() * 1e3, item_count / total_time.count() / 1e6, add_time.count() * 1e3, build_time.count() * 1e3);
+    }
+}
@@ -0,0 +1,62 @@
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <thread>
+#include "jg_png_writer.h"
+
+// Rasterizes a large diagram-like scene with a growing number of threads, then encodes it once,
+// and reports the throughput of each step.
+int main()
+{
+    const jg::size size{4000, 3000};
+    const jg::svg_paint_attributes paint{"#d7eff6", "black", "3"};
+
+    const auto draw = [&](jg::png_writer& png)
+    {
+        png.write_background();
+        png.write_grid(50);
+
+        for (float y = 50; y + 100 < size.height; y += 150)
+        {
+            for (float x = 50; x + 300 < size.width; x += 400)
+            {
+                png.write_rect({x, y, 120, 60}, paint);
+                png.write_ellipse({x + 220, y + 30}, 60, 30, paint);
+                png.write_rhombus({x + 60, y + 70, 120, 30}, paint);
+                png.write_arrow({x + 120, y + 30}, {x + 160, y + 30}, {"none", "black", "3"});
+            }
+        }
+    };
+
+    const auto megapixels = static_cast<double>(size.width) * static_cast<double>(size.height) / 1e6;
+    const unsigned max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    std::printf("hardware threads: %u\n", max_threads);
+
+    for (unsigned threads = 1; threads <= std::max(max_threads, 8u); threads *= 2)
+    {
+        std::ostringstream stream;
+        jg::png_writer png{stream, size, threads};
+        draw(png);
+
+        constexpr int runs = 3;
+        const auto start = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < runs; ++i)
+            png.render();
+
+        const std::chrono::duration<double> elapsed = (std::chrono::steady_clock::now() - start) / runs;
+        std::printf("render  %2u thread(s): %8.1f ms  %8.1f Mpixel/s\n", threads, elapsed.count() * 1e3, megapixels / elapsed.count());
+    }
+
+    std::ostringstream stream;
+    jg::png_writer png{stream, size};
+    draw(png);
+
+    const auto start = std::chrono::steady_clock::now();
+    png.finish();
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::printf("render + encode:       %8.1f ms  %8.1f Mpixel/s  %zu bytes\n",
+                elapsed.count() * 1e3, megapixels / elapsed.count(), stream.str().size());
+}
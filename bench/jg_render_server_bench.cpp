@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Compares rendering diagrams through one long-running jg_diag --serve process with starting a
+// process per diagram, in requests per second and latency percentiles. POSIX only.
+
+namespace
+{
+
+using clock_type = std::chrono::steady_clock;
+
+const std::string description = "title jg-diagram-sample\n"
+                                "rectangle 50 100 300 100 Rectangle\n"
+                                "ellipse 500 50 300 100 Ellipse\n"
+                                "rhombus 550 500 300 100 Rhombus\n"
+                                "parallelogram 50 500 400 100 Parallelogram\n"
+                                "circle 200 250 150 150 Circle\n"
+                                "arrow 0 1\n"
+                                "arrow 1 2\n"
+                                "arrow 2 3\n"
+                                "arrow 3 4\n"
+                                "arrow 4 0\n";
+
+const std::string request = std::to_string(description.size()) + "\n" + description;
+
+struct server_process final
+{
+    pid_t pid{};
+    int input{-1};
+    int output{-1};
+};
+
+server_process start_server(const char* path, const char* threads)
+{
+    int to_server[2];
+    int from_server[2];
+
+    if (pipe(to_server) != 0 || pipe(from_server) != 0)
+    {
+        std::perror("pipe");
+        std::exit(1);
+    }
+
+    const pid_t pid = fork();
+
+    if (pid == 0)
+    {
+        dup2(to_server[0], 0);
+        dup2(from_server[1], 1);
+        close(to_server[0]);
+        close(to_server[1]);
+        close(from_server[0]);
+        close(from_server[1]);
+        execl(path, path, "--serve", "--threads", threads, static_cast<char*>(nullptr));
+        _exit(127);
+    }
+
+    close(to_server[0]);
+    close(from_server[1]);
+    return {pid, to_server[1], from_server[0]};
+}
+
+void stop_server(server_process& server)
+{
+    close(server.input);
+    close(server.output);
+    waitpid(server.pid, nullptr, 0);
+}
+
+bool write_all(int fd, std::string_view data)
+{
+    while (!data.empty())
+    {
+        const auto written = write(fd, data.data(), data.size());
+
+        if (written <= 0)
+            return false;
+
+        data.remove_prefix(static_cast<size_t>(written));
+    }
+
+    return true;
+}
+
+// Reads framed responses ("ok <size>\n" and the body) from a pipe.
+class response_reader final
+{
+public:
+    explicit response_reader(int fd)
+        : m_fd{fd}
+    {}
+
+    bool read_response()
+    {
+        size_t newline;
+
+        while ((newline = m_buffer.find('\n', m_pos)) == std::string::npos)
+        {
+            if (!fill())
+                return false;
+        }
+
+        const std::string_view header{m_buffer.data() + m_pos, newline - m_pos};
+
+        if (header.substr(0, 3) != "ok ")
+            return false;
+
+        const size_t end = newline + 1 + std::stoul(std::string{header.substr(3)});
+
+        while (m_buffer.size() < end)
+        {
+            if (!fill())
+                return false;
+        }
+
+        m_pos = end;
+
+        if (m_pos > 1 << 20)
+        {
+            m_buffer.erase(0, m_pos);
+            m_pos = 0;
+        }
+
+        return true;
+    }
+
+private:
+    bool fill()
+    {
+        char data[65536];
+        const auto count = read(m_fd, data, sizeof(data));
+
+        if (count <= 0)
+            return false;
+
+        m_buffer.append(data, static_cast<size_t>(count));
+        return true;
+    }
+
+    int m_fd;
+    std::string m_buffer;
+    size_t m_pos{};
+};
+
+void report(const char* name, size_t count, double seconds)
+{
+    std::printf("%-32s %9.0f req/s\n", name, static_cast<double>(count) / seconds);
+}
+
+void report(const char* name, std::vector<double>& latencies, double seconds)
+{
+    std::sort(latencies.begin(), latencies.end());
+
+    const auto percentile = [&](size_t p) { return latencies[(latencies.size() - 1) * p / 100]; };
+
+    std::printf("%-32s %9.0f req/s  p50 %8.1f us  p99 %8.1f us\n", name,
+                static_cast<double>(latencies.size()) / seconds, percentile(50), percentile(99));
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    const char* path = argc > 1 ? argv[1] : JG_DIAG_PATH;
+    std::signal(SIGPIPE, SIG_IGN);
+
+    // A new process for every diagram, which is what the server saves.
+    {
+        constexpr int count = 200;
+        std::vector<double> latencies;
+        const auto start = clock_type::now();
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto request_start = clock_type::now();
+            auto server = start_server(path, "1");
+            response_reader reader{server.output};
+
+            if (!write_all(server.input, request) || !reader.read_response())
+            {
+                std::fprintf(stderr, "no response from %s\n", path);
+                return 1;
+            }
+
+            stop_server(server);
+            latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - request_start).count());
+        }
+
+        report("process per diagram", latencies, std::chrono::duration<double>(clock_type::now() - start).count());
+    }
+
+    // One request at a time through a running server: the latency a client sees.
+    {
+        constexpr int count = 2000;
+        auto server = start_server(path, "1");
+        response_reader reader{server.output};
+        std::vector<double> latencies;
+        const auto start = clock_type::now();
+
+        for (int i = 0; i < count; ++i)
+        {
+            const auto request_start = clock_type::now();
+
+            if (!write_all(server.input, request) || !reader.read_response())
+            {
+                std::fprintf(stderr, "no response from %s\n", path);
+                return 1;
+            }
+
+            latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - request_start).count());
+        }
+
+        report("server, round trips", latencies, std::chrono::duration<double>(clock_type::now() - start).count());
+        stop_server(server);
+    }
+
+    // Requests written as fast as the server takes them, which lets its workers overlap.
+    const unsigned hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned threads = 1; threads <= hardware_threads; threads *= 2)
+    {
+        constexpr size_t count = 20000;
+        auto server = start_server(path, std::to_string(threads).c_str());
+        response_reader reader{server.output};
+        const auto start = clock_type::now();
+
+        std::thread writer{[&]
+        {
+            for (size_t i = 0; i < count; ++i)
+                if (!write_all(server.input, request))
+                    return;
+        }};
+
+        size_t responses = 0;
+
+        while (responses < count && reader.read_response())
+            ++responses;
+
+        writer.join();
+
+        const auto name = "server, pipelined, " + std::to_string(threads) + " thread(s)";
+        report(name.c_str(), responses, std::chrono::duration<double>(clock_type::now() - start).count());
+        stop_server(server);
+    }
+}
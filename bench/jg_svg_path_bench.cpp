@@ -0,0 +1,86 @@
+#include <chrono>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include "jg_svg_path.h"
+#include "jg_svg_writer.h"
+
+namespace
+{
+
+constexpr int path_count = 1000000;
+
+jg::rect shape_bounds(int i)
+{
+    return {static_cast<float>(i % 997) * 1.5f, static_cast<float>(i % 991) * 2.25f, 120.5f, 60};
+}
+
+template <typename TBuild>
+void measure(const char* name, TBuild&& build)
+{
+    size_t bytes = 0;
+    const auto start = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < path_count; ++i)
+        bytes += build(shape_bounds(i));
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::printf("%-22s %6.1f bytes/path  %7.3f us/path  %7.1f MB/s\n", name,
+                static_cast<double>(bytes) / path_count, elapsed.count() * 1e6 / path_count, static_cast<double>(bytes) / elapsed.count() / 1e6);
+}
+
+} // namespace
+
+// Builds the same rhombus path with svg_path and with the ostringstream formatting svg_writer
+// used before, then writes a whole document of shapes through svg_writer.
+int main()
+{
+    const jg::svg_number_format format;
+    jg::svg_path path{format};
+
+    measure("svg_path", [&](jg::rect r)
+    {
+        path.clear();
+        path.move_to({r.x, r.y + r.height / 2})
+            .line_to({r.x + r.width / 2, r.y})
+            .line_to({r.x + r.width, r.y + r.height / 2})
+            .line_to({r.x + r.width / 2, r.y + r.height})
+            .close();
+
+        return path.str().size();
+    });
+
+    measure("ostringstream", [&](jg::rect r)
+    {
+        std::ostringstream stream;
+        stream << "M"  << r.x << " " << r.y + r.height / 2
+               << " L" << r.x + r.width / 2 << " " << r.y
+               << " L" << r.x + r.width << " " << r.y + r.height / 2
+               << " L" << r.x + r.width / 2 << " " << r.y + r.height
+               << " Z";
+
+        return stream.str().size();
+    });
+
+    constexpr int shape_count = 100000;
+    const jg::svg_paint_attributes paint{"#d7eff6", "black", "3"};
+    std::ostringstream document;
+
+    const auto start = std::chrono::steady_clock::now();
+    {
+        jg::svg_writer svg{document, {4000, 3000}};
+
+        for (int i = 0; i < shape_count; ++i)
+        {
+            const auto r = shape_bounds(i);
+            svg.write_rhombus(r, paint);
+            svg.write_rect(r, paint);
+            svg.write_ellipse({r.x, r.y}, r.width / 2, r.height / 2, paint);
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    const auto bytes = static_cast<double>(document.str().size());
+    std::printf("svg_writer document    %6.1f bytes/shape %7.3f us/shape %7.1f MB/s\n",
+                bytes / (shape_count * 3), elapsed.count() * 1e6 / (shape_count * 3), bytes / elapsed.count() / 1e6);
+}
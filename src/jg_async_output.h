@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <cerrno>
+#include <climits>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace jg
+{
+
+// A stream buffer that serializes into fixed-size buffers and hands the filled ones to a dedicated
+// I/O thread, which writes them to a file descriptor. Serialization only waits for I/O when all
+// buffers are in flight, which bounds the memory used to buffer_count * buffer_size. Consecutive
+// filled buffers are written with a single writev() where available.
+//
+// A flush (sync) waits until everything written so far has reached the file descriptor. Write
+// errors put the stream in a bad state at the next overflow or flush.
+class async_fd_streambuf final : public std::streambuf
+{
+public:
+    async_fd_streambuf(int fd, size_t buffer_size = 64 * 1024, size_t buffer_count = 4)
+        : m_fd{fd}
+        , m_buffers(std::max<size_t>(buffer_count, 2), std::vector<char>(std::max<size_t>(buffer_size, 1)))
+    {
+        for (size_t i = 1; i < m_buffers.size(); ++i)
+            m_free.push_back(i);
+
+        set_buffer(0);
+        m_thread = std::thread{[this] { write_loop(); }};
+    }
+
+    async_fd_streambuf(const async_fd_streambuf&) = delete;
+    async_fd_streambuf& operator=(const async_fd_streambuf&) = delete;
+
+    ~async_fd_streambuf()
+    {
+        sync();
+
+        {
+            std::lock_guard lock{m_mutex};
+            m_done = true;
+        }
+
+        m_changed.notify_all();
+        m_thread.join();
+    }
+
+protected:
+    int_type overflow(int_type ch) override
+    {
+        if (!hand_over())
+            return traits_type::eof();
+
+        if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        {
+            *pptr() = traits_type::to_char_type(ch);
+            pbump(1);
+        }
+
+        return traits_type::not_eof(ch);
+    }
+
+    int sync() override
+    {
+        if (!hand_over())
+            return -1;
+
+        std::unique_lock lock{m_mutex};
+        m_changed.wait(lock, [&] { return (m_filled.empty() && !m_writing) || m_failed; });
+
+        return m_failed ? -1 : 0;
+    }
+
+private:
+    void set_buffer(size_t index)
+    {
+        m_current = index;
+        auto& buffer = m_buffers[index];
+        setp(buffer.data(), buffer.data() + buffer.size());
+    }
+
+    // Queues the current buffer for writing, if it has anything in it, and continues in a free
+    // buffer. Waits for the I/O thread when there is none.
+    bool hand_over()
+    {
+        const auto size = static_cast<size_t>(pptr() - pbase());
+
+        std::unique_lock lock{m_mutex};
+
+        if (m_failed)
+            return false;
+
+        if (size == 0)
+            return true;
+
+        m_filled.push_back({m_current, size});
+        m_changed.notify_all();
+
+        m_changed.wait(lock, [&] { return !m_free.empty() || m_failed; });
+
+        if (m_failed)
+            return false;
+
+        const size_t next = m_free.front();
+        m_free.pop_front();
+        lock.unlock();
+
+        set_buffer(next);
+
+        return true;
+    }
+
+    void write_loop()
+    {
+        std::unique_lock lock{m_mutex};
+
+        for (;;)
+        {
+            m_changed.wait(lock, [&] { return !m_filled.empty() || m_done; });
+
+            if (m_filled.empty())
+                return;
+
+            std::vector<std::pair<size_t, size_t>> batch(m_filled.begin(), m_filled.end());
+            m_filled.clear();
+            m_writing = true;
+            lock.unlock();
+
+            const bool ok = write_all(batch);
+
+            lock.lock();
+            m_writing = false;
+            m_failed = m_failed || !ok;
+
+            for (const auto& [index, _] : batch)
+                m_free.push_back(index);
+
+            m_changed.notify_all();
+        }
+    }
+
+    bool write_all(const std::vector<std::pair<size_t, size_t>>& batch)
+    {
+#ifdef _WIN32
+        for (const auto& [index, size] : batch)
+        {
+            for (size_t written = 0; written < size;)
+            {
+                const int result = _write(m_fd, m_buffers[index].data() + written, static_cast<unsigned>(size - written));
+
+                if (result <= 0)
+                    return false;
+
+                written += static_cast<size_t>(result);
+            }
+        }
+
+        return true;
+#else
+        std::vector<iovec> chunks;
+
+        for (const auto& [index, size] : batch)
+            chunks.push_back({m_buffers[index].data(), size});
+
+        for (size_t first = 0; first < chunks.size();)
+        {
+            const auto count = static_cast<int>(std::min<size_t>(chunks.size() - first, IOV_MAX));
+            const ssize_t result = ::writev(m_fd, chunks.data() + first, count);
+
+            if (result < 0 && errno == EINTR)
+                continue;
+
+            // Nothing written without an error would repeat forever, so it counts as one.
+            if (result <= 0)
+                return false;
+
+            // Skip what was written, which may end part way into a chunk.
+            for (auto remaining = static_cast<size_t>(result); remaining > 0;)
+            {
+                auto& chunk = chunks[first];
+                const size_t step = std::min(remaining, chunk.iov_len);
+                chunk.iov_base = static_cast<char*>(chunk.iov_base) + step;
+                chunk.iov_len -= step;
+                remaining -= step;
+
+                if (chunk.iov_len == 0)
+                    ++first;
+            }
+        }
+
+        return true;
+#endif
+    }
+
+    int m_fd{};
+    std::vector<std::vector<char>> m_buffers;
+    size_t m_current{};
+
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<size_t> m_free;
+    std::deque<std::pair<size_t, size_t>> m_filled; // buffer index and size
+    bool m_writing{};
+    bool m_failed{};
+    bool m_done{};
+    std::thread m_thread;
+};
+
+// An output stream over an async_fd_streambuf. Destroying it writes out whatever is left.
+class async_fd_ostream final : public std::ostream
+{
+public:
+    async_fd_ostream(int fd, size_t buffer_size = 64 * 1024, size_t buffer_count = 4)
+        : std::ostream{nullptr}
+        , m_buffer{fd, buffer_size, buffer_count}
+    {
+        rdbuf(&m_buffer);
+    }
+
+private:
+    async_fd_streambuf m_buffer;
+};
+
+} // namespace jg
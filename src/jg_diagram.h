@@ -0,0 +1,544 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+#include "jg_png_writer.h"
+#include "jg_svg_writer.h"
+
+namespace jg
+{
+
+using anchor_array = std::array<jg::point, 4>;
+
+template <typename TAnchorPolicy>
+class shape final
+{
+public:
+    shape(jg::rect bounds, std::string_view text)
+        : m_bounds{bounds}
+        , m_text{text}
+    {}
+
+    jg::rect bounds() const
+    {
+        return m_bounds;
+    }
+
+    std::string_view text() const
+    {
+        return m_text;
+    }
+
+    anchor_array anchors() const
+    {
+        return TAnchorPolicy::anchors(m_bounds);
+    }
+
+private:
+    jg::rect m_bounds;
+    std::string m_text;
+};
+
+//     x
+//  x     x
+//     x
+struct rectangle_anchors final
+{
+    static anchor_array anchors(const jg::rect& bounds)
+    {
+        return
+        {
+            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width / 2, bounds.y},
+            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
+        };
+    }
+};
+
+using rectangle = shape<rectangle_anchors>;
+
+//     x
+//  x     x
+//     x
+struct rhombus_anchors final
+{
+    static anchor_array anchors(const jg::rect& bounds)
+    {
+        return
+        {
+            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width / 2, bounds.y},
+            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
+        };
+    }
+};
+
+using rhombus = shape<rhombus_anchors>;
+
+//       x
+//  x      x
+//    x
+struct parallelogram_anchors final
+{
+    static anchor_array anchors(const jg::rect& bounds)
+    {
+        return
+        {
+            jg::point{bounds.x + bounds.height / 2,                bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width / 2,                 bounds.y},
+            jg::point{bounds.x + bounds.width - bounds.height / 2, bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width / 2,                 bounds.y + bounds.height}
+        };
+    }
+};
+
+using parallelogram = shape<parallelogram_anchors>;
+
+//      x
+//  x       x
+//      x
+struct ellipse_anchors final
+{
+    static anchor_array anchors(const jg::rect& bounds)
+    {
+        return
+        {
+            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
+            jg::point{bounds.x + bounds.width / 2, bounds.y},
+            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
+        };
+    }
+};
+
+using ellipse = shape<ellipse_anchors>;
+
+//     x
+//  x     x
+//     x
+struct circle_anchors final
+{
+    static anchor_array anchors(const jg::rect& bounds)
+    {
+        const auto diameter = std::min(bounds.width, bounds.height);
+
+        return
+        {
+            jg::point{bounds.x               , bounds.y + diameter / 2},
+            jg::point{bounds.x + diameter    , bounds.y + diameter / 2},
+            jg::point{bounds.x + diameter / 2, bounds.y},
+            jg::point{bounds.x + diameter / 2, bounds.y + diameter}
+        };
+    }
+};
+
+using circle = shape<circle_anchors>;
+
+using item_id = size_t;
+
+enum class line_kind
+{
+    filled_arrow
+};
+
+class line final
+{
+public:
+    item_id source_id{};
+    item_id target_id{};
+    line_kind kind{};
+};
+
+// https://www.bfilipek.com/2018/06/variant.html#overload
+template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
+template<class... Ts> overload(Ts...) -> overload<Ts...>;
+
+class diagram final
+{
+public:
+    using shapes = std::variant<rectangle, rhombus, parallelogram, ellipse, circle>;
+
+    diagram(std::string_view title = "")
+        : m_title{title}
+    {}
+
+    // Ids are handed out in order, starting at 1.
+    template <typename T>
+    item_id add_item(T&& item)
+    {
+        m_items.emplace_back(std::forward<T>(item));
+        fit(m_size, m_items.back());
+        return m_items.size();
+    }
+
+    void add_item(line&& item)
+    {
+        m_lines.push_back(std::move(item));
+    }
+
+    // A scale below 1 renders a zoomed out overview, which drops or simplifies whatever ends up
+    // too small to see at that scale (see the level of detail thresholds below). The scale must be
+    // positive and finite. Coordinates are rounded to the given number of decimals.
+    void write_svg(std::ostream& stream, float scale = 1, int precision = 2) const
+    {
+        jg::verify(scale > 0 && std::isfinite(scale));
+
+        jg::svg_writer svg{stream, m_size, scale, precision};
+        write(svg, scale);
+    }
+
+    // Rasterizes in horizontal bands, one per thread. The scale works as for write_svg.
+    void write_png(std::ostream& stream, unsigned thread_count = std::thread::hardware_concurrency(), float scale = 1) const
+    {
+        jg::verify(scale > 0 && std::isfinite(scale));
+
+        jg::png_writer png{stream, m_size, thread_count, scale};
+        write(png, scale);
+        png.finish();
+    }
+
+    // TWriter is svg_writer or any writer with the same interface, like png_writer.
+    template <typename TWriter>
+    void write(TWriter& writer, float scale) const
+    {
+        const bool zoomed_out = scale < 1;
+        const auto visible = [&](float length, float threshold)
+        {
+            return !zoomed_out || length * scale >= threshold;
+        };
+
+        writer.write_background();
+
+        constexpr float grid_distance = 50;
+
+        // The grid lines are 1 unit wide, which is less than a pixel as soon as the diagram is zoomed
+        // out. Thinner lines only add bytes and a grey haze, however far apart they are.
+        if (!zoomed_out)
+        {
+            writer.write_comment("Grid");
+            writer.write_grid(grid_distance);
+        }
+
+        const jg::svg_paint_attributes default_paint{"#d7eff6", "black", "3"};
+
+        constexpr float font_size = 25;
+        jg::svg_text_attributes default_text;
+        default_text.font.size = writer.number_format().to_string(font_size);
+        default_text.font.family = "sans-serif";
+        default_text.font.weight = "bold";
+        default_text.text_anchor = svg_text_anchor::middle;
+        default_text.dominant_baseline = svg_dominant_baseline::middle;
+
+        constexpr float anchor_radius = 5;
+        const bool labels_visible = visible(font_size, min_text_pixels);
+        const bool anchors_visible = visible(anchor_radius * 2, min_anchor_pixels);
+
+        const auto bounds_of = [](const shapes& item)
+        {
+            return std::visit([](const auto& shape) { return shape.bounds(); }, item);
+        };
+
+        const auto shape_visible = [&](const jg::rect& bounds)
+        {
+            return visible(std::max(bounds.width, bounds.height), min_shape_pixels);
+        };
+
+        // Shapes too small to see are merged into one rect per cell of a coarse pixel grid, picked
+        // by the shape's center.
+        const float cell_size = min_shape_pixels / scale;
+        std::set<std::pair<int, int>> aggregate_cells;
+
+        const auto cell_of = [&](const jg::rect& bounds)
+        {
+            return std::pair<int, int>{static_cast<int>(std::floor((bounds.x + bounds.width / 2) / cell_size)),
+                                       static_cast<int>(std::floor((bounds.y + bounds.height / 2) / cell_size))};
+        };
+
+        // Every distinct shape kind and size is written once as a symbol, and so is every distinct
+        // set of anchor markers, which shapes of different kinds often share. Each shape is then
+        // just an instance of those, placed at its position.
+        std::map<std::tuple<size_t, float, float>, std::pair<std::string, std::string>> symbols;
+        std::map<anchor_array, std::string, anchor_order> anchor_symbols;
+
+        for (const auto& item : m_items)
+        {
+            const jg::rect bounds = bounds_of(item);
+
+            if (!shape_visible(bounds))
+                continue;
+
+            const auto [symbol, inserted] = symbols.insert({{item.index(), bounds.width, bounds.height}, {}});
+
+            if (!inserted)
+                continue;
+
+            symbol->second.first = "shape" + std::to_string(symbols.size() - 1);
+            writer.begin_symbol(symbol->second.first);
+
+            std::visit(jg::overload
+            {
+                [&](const jg::rectangle&)
+                {
+                    writer.write_rect({0, 0, bounds.width, bounds.height}, default_paint);
+                },
+                [&](const jg::rhombus&)
+                {
+                    writer.write_rhombus({0, 0, bounds.width, bounds.height}, default_paint);
+                },
+                [&](const jg::parallelogram&)
+                {
+                    writer.write_parallelogram({0, 0, bounds.width, bounds.height}, default_paint);
+                },
+                [&](const jg::ellipse&)
+                {
+                    writer.write_ellipse({bounds.width / 2, bounds.height / 2}, bounds.width / 2, bounds.height / 2, default_paint);
+                },
+                [&](const jg::circle&)
+                {
+                    const auto radius = std::min(bounds.width, bounds.height) / 2;
+                    writer.write_circle({radius, radius}, radius, default_paint);
+                }
+            }, item);
+
+            writer.end_symbol();
+
+            if (!anchors_visible)
+                continue;
+
+            const auto anchors = std::visit([&](const auto& shape)
+            {
+                using shape_type = std::decay_t<decltype(shape)>;
+                return shape_type{{0, 0, bounds.width, bounds.height}, ""}.anchors();
+            }, item);
+
+            const auto [anchor_symbol, anchors_inserted] = anchor_symbols.insert({anchors, "anchors" + std::to_string(anchor_symbols.size())});
+            symbol->second.second = anchor_symbol->second;
+
+            if (!anchors_inserted)
+                continue;
+
+            writer.begin_symbol(anchor_symbol->second);
+
+            for (const auto& anchor : anchors)
+                writer.write_circle({anchor.x, anchor.y}, anchor_radius, {"red", "none", "1"});
+
+            writer.end_symbol();
+        }
+
+        for (const auto& item : m_items)
+        {
+            const jg::rect bounds = bounds_of(item);
+
+            if (!shape_visible(bounds))
+            {
+                aggregate_cells.insert(cell_of(bounds));
+                continue;
+            }
+
+            const auto& [shape_symbol, anchor_symbol] = symbols.find({item.index(), bounds.width, bounds.height})->second;
+            writer.write_use(shape_symbol, {bounds.x, bounds.y});
+
+            std::visit([&](const auto& shape)
+            {
+                if (labels_visible)
+                {
+                    writer.write_comment(shape.text());
+                    writer.write_text({bounds.x + bounds.width / 2, bounds.y + bounds.height / 2}, shape.text(), default_text);
+                }
+            }, item);
+
+            if (anchors_visible)
+                writer.write_use(anchor_symbol, {bounds.x, bounds.y});
+        };
+
+        // The cells are ordered by column, so every vertical run of cells becomes a single rect.
+        for (auto cell = aggregate_cells.begin(); cell != aggregate_cells.end();)
+        {
+            const auto [x, y] = *cell;
+            int count = 0;
+
+            while (cell != aggregate_cells.end() && *cell == std::pair<int, int>{x, y + count})
+            {
+                ++cell;
+                ++count;
+            }
+
+            writer.write_rect({static_cast<float>(x) * cell_size, static_cast<float>(y) * cell_size, cell_size, cell_size * static_cast<float>(count)},
+                              {default_paint.fill, "none", "0"});
+        }
+
+        const jg::svg_paint_attributes default_line{"none", "black", "3"};
+
+        writer.write_comment("Arrows");
+
+        const bool arrowheads_visible = visible(arrowhead_length, min_arrowhead_pixels);
+
+        // Connectors that start and end at the same pixels are drawn once, and so are connectors
+        // between the same two cells of merged shapes.
+        std::set<std::array<int, 4>> drawn_lines;
+        std::set<std::array<int, 4>> drawn_cell_lines;
+
+        for (const auto& line : m_lines)
+        {
+            const auto& source = item(line.source_id);
+            const auto& target = item(line.target_id);
+            const jg::rect source_bounds = bounds_of(source);
+            const jg::rect target_bounds = bounds_of(target);
+
+            std::pair<jg::point, jg::point> anchors;
+
+            // Between merged shapes, a connector runs from cell center to cell center. Within a
+            // cell or to a neighbouring one it would only cross the cells' own rects, so it's
+            // left out; only connectors that reach further are drawn.
+            if (!shape_visible(source_bounds) && !shape_visible(target_bounds))
+            {
+                auto from = cell_of(source_bounds);
+                auto to = cell_of(target_bounds);
+
+                if (std::abs(from.first - to.first) <= 1 && std::abs(from.second - to.second) <= 1)
+                    continue;
+
+                // Without arrowheads, a connector looks the same in either direction.
+                if (!arrowheads_visible && to < from)
+                    std::swap(from, to);
+
+                if (!drawn_cell_lines.insert({from.first, from.second, to.first, to.second}).second)
+                    continue;
+
+                anchors = {{(static_cast<float>(from.first) + 0.5f) * cell_size, (static_cast<float>(from.second) + 0.5f) * cell_size},
+                           {(static_cast<float>(to.first) + 0.5f) * cell_size, (static_cast<float>(to.second) + 0.5f) * cell_size}};
+            }
+            else
+            {
+                const auto source_anchors = std::visit([&] (const auto& shape)
+                {
+                    return shape.anchors();
+                }, source);
+
+                const auto target_anchors = std::visit([&] (const auto& shape)
+                {
+                    return shape.anchors();
+                }, target);
+
+                float shortest_distance = std::numeric_limits<float>::max();
+
+                for (const auto& source_anchor : source_anchors)
+                {
+                    for (const auto& target_anchor : target_anchors)
+                    {
+                        const float dx = target_anchor.x - source_anchor.x;
+                        const float dy = target_anchor.y - source_anchor.y;
+                        const float distance = std::hypotf(dx, dy);
+
+                        if (distance < shortest_distance)
+                        {
+                            shortest_distance = distance;
+                            anchors = {source_anchor, target_anchor};
+                        }
+                    }
+                }
+
+                jg::debug_verify(shortest_distance != std::numeric_limits<float>::max());
+            }
+
+            if (zoomed_out)
+            {
+                const float length = std::hypotf(anchors.second.x - anchors.first.x, anchors.second.y - anchors.first.y);
+
+                if (!visible(length, min_line_pixels))
+                    continue;
+
+                const std::array<int, 4> pixels
+                {
+                    static_cast<int>(std::lround(anchors.first.x * scale)),
+                    static_cast<int>(std::lround(anchors.first.y * scale)),
+                    static_cast<int>(std::lround(anchors.second.x * scale)),
+                    static_cast<int>(std::lround(anchors.second.y * scale))
+                };
+
+                if (!drawn_lines.insert(pixels).second)
+                    continue;
+            }
+
+            if (arrowheads_visible)
+                writer.write_arrow({anchors.first.x, anchors.first.y},
+                                   {anchors.second.x, anchors.second.y},
+                                   default_line);
+            else
+                writer.write_line({anchors.first.x, anchors.first.y},
+                                  {anchors.second.x, anchors.second.y},
+                                  default_line);
+        }
+
+        if (labels_visible)
+            writer.write_title(m_title);
+
+        writer.write_border();
+    }
+
+private:
+    friend class diagram_builder;
+
+    // Grows the size to keep a margin of 50 around the item.
+    static void fit(jg::size& size, const shapes& item)
+    {
+        std::visit([&](const auto& shape)
+        {
+            const auto& bounds = shape.bounds();
+
+            if (bounds.x + bounds.width > size.width - 50)
+                size.width = bounds.x + bounds.width + 50;
+
+            if (bounds.y + bounds.height > size.height - 50)
+                size.height = bounds.y + bounds.height + 50;
+
+        }, item);
+    }
+
+    const shapes& item(item_id id) const
+    {
+        verify(id >= 1 && id <= m_items.size());
+        return m_items[id - 1];
+    }
+
+    // Orders anchor sets by their coordinates, to find the ones that are the same.
+    struct anchor_order final
+    {
+        bool operator()(const anchor_array& lhs, const anchor_array& rhs) const
+        {
+            return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](jg::point l, jg::point r)
+            {
+                return std::tie(l.x, l.y) < std::tie(r.x, r.y);
+            });
+        }
+    };
+
+    // Level of detail thresholds for zoomed out renders, in output pixels. Anything smaller is
+    // dropped (labels, anchors, connectors), simplified (arrowheads become plain lines) or merged
+    // (shapes, and the connectors between them).
+    static constexpr float min_text_pixels = 6;
+    static constexpr float min_anchor_pixels = 2;
+    static constexpr float min_shape_pixels = 4;
+    static constexpr float min_line_pixels = 2;
+    static constexpr float min_arrowhead_pixels = 3;
+    static constexpr float arrowhead_length = 20;
+
+    std::string m_title;
+    jg::size m_size;
+    std::vector<shapes> m_items; // at their id - 1
+    std::vector<line> m_lines;
+};
+
+} // namespace jg
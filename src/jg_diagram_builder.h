@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <jg_verify.h>
+#include "jg_diagram.h"
+
+namespace jg
+{
+
+// Builds a diagram from several producer threads. Each producer adds items to its own shard, so
+// adding never takes a lock, and ids are reserved in blocks from one atomic counter. The ids a
+// shard hands out are only used for referring to items in lines; build() merges the shards in
+// shard order and renumbers everything, so the resulting diagram only depends on what each shard
+// was given, not on how the producers happened to be scheduled.
+class diagram_builder final
+{
+public:
+    // Aligned to keep the shards of different threads off each other's cache lines.
+    class alignas(64) shard final
+    {
+    public:
+        template <typename T>
+        item_id add_item(T&& item)
+        {
+            const auto id = reserve_id();
+            m_items.emplace_back(std::forward<T>(item));
+            diagram::fit(m_size, m_items.back());
+            return id;
+        }
+
+        void add_item(line&& item)
+        {
+            m_lines.push_back(std::move(item));
+        }
+
+    private:
+        friend class diagram_builder;
+
+        explicit shard(std::atomic<item_id>& next_id)
+            : m_next_id{next_id}
+        {}
+
+        // Every id of a block is handed out before the next block is reserved, so the items of
+        // the shard's n-th block are its items from n * id_block_size on.
+        item_id reserve_id()
+        {
+            if (m_next == m_end)
+            {
+                m_next = m_next_id.fetch_add(id_block_size, std::memory_order_relaxed);
+                m_end = m_next + id_block_size;
+                m_blocks.push_back(m_next);
+            }
+
+            return m_next++;
+        }
+
+        // Ids handed out before are gone with the items, so the rest of the current block is too.
+        void clear()
+        {
+            m_next = m_end = 0;
+            m_blocks.clear();
+            m_items.clear();
+            m_lines.clear();
+            m_size = {};
+        }
+
+        std::atomic<item_id>& m_next_id;
+        item_id m_next{};
+        item_id m_end{};
+        std::vector<item_id> m_blocks;
+        std::vector<diagram::shapes> m_items;
+        std::vector<line> m_lines;
+        jg::size m_size;
+    };
+
+    diagram_builder(std::string_view title, size_t shard_count)
+        : m_title{title}
+    {
+        for (size_t i = 0; i < shard_count; ++i)
+            m_shards.push_back(std::unique_ptr<shard>{new shard{m_next_id}});
+    }
+
+    size_t shard_count() const
+    {
+        return m_shards.size();
+    }
+
+    // Each shard must only be used by one thread at a time.
+    shard& get_shard(size_t index)
+    {
+        verify(index < m_shards.size());
+        return *m_shards[index];
+    }
+
+    // Moves the items of all shards into a new diagram. Must only be called once all producers are
+    // done, and leaves the builder empty.
+    //
+    // Renumbering is arithmetic: a shard's items get the diagram ids following those of the shards
+    // before it, and every reserved block maps to the diagram id of its first item, so a builder id
+    // translates through a flat table indexed by its block. With those offsets known up front,
+    // every shard is moved into its own range of the diagram on a thread of its own.
+    diagram build()
+    {
+        const item_id block_count = (m_next_id.load(std::memory_order_relaxed) - 1) / id_block_size;
+        std::vector<item_id> block_ids(block_count);
+        std::vector<std::pair<size_t, size_t>> offsets; // of every shard's items and lines
+        size_t item_count = 0;
+        size_t line_count = 0;
+
+        diagram result{m_title};
+
+        for (const auto& shard : m_shards)
+        {
+            for (size_t i = 0; i < shard->m_blocks.size(); ++i)
+                block_ids[(shard->m_blocks[i] - 1) / id_block_size] = item_count + i * id_block_size + 1;
+
+            offsets.push_back({item_count, line_count});
+            item_count += shard->m_items.size();
+            line_count += shard->m_lines.size();
+            result.m_size = {std::max(result.m_size.width, shard->m_size.width), std::max(result.m_size.height, shard->m_size.height)};
+        }
+
+        // Shapes can't be default constructed, so the range starts out as empty rectangles.
+        result.m_items.resize(item_count, rectangle{{}, ""});
+        result.m_lines.resize(line_count);
+
+        const auto translate = [&](item_id id)
+        {
+            verify(id >= 1 && (id - 1) / id_block_size < block_count);
+            const item_id block_id = block_ids[(id - 1) / id_block_size];
+            verify(block_id != 0 && block_id + (id - 1) % id_block_size <= item_count);
+            return block_id + (id - 1) % id_block_size;
+        };
+
+        const auto merge = [&](size_t index)
+        {
+            auto& shard = *m_shards[index];
+            std::move(shard.m_items.begin(), shard.m_items.end(), result.m_items.begin() + static_cast<std::ptrdiff_t>(offsets[index].first));
+
+            auto line = result.m_lines.begin() + static_cast<std::ptrdiff_t>(offsets[index].second);
+
+            for (const auto& item : shard.m_lines)
+                *line++ = {translate(item.source_id), translate(item.target_id), item.kind};
+        };
+
+        std::vector<std::thread> threads;
+
+        for (size_t index = 1; index < m_shards.size(); ++index)
+            threads.emplace_back(merge, index);
+
+        if (!m_shards.empty())
+            merge(0);
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto& shard : m_shards)
+            shard->clear();
+
+        return result;
+    }
+
+private:
+    static constexpr item_id id_block_size = 1024;
+
+    std::string m_title;
+    std::atomic<item_id> m_next_id{1};
+    std::vector<std::unique_ptr<shard>> m_shards;
+};
+
+} // namespace jg
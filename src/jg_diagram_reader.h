@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cmath>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "jg_diagram.h"
+
+namespace jg
+{
+
+// The largest coordinate a description may use, which keeps what a request costs to render bounded.
+constexpr float max_diagram_coordinate = 1e6f;
+
+// Reads a diagram from its text description, one item per line:
+//
+//     title jg-diagram-sample
+//     rectangle 50 100 300 100 Rectangle
+//     ellipse 500 50 300 100 Ellipse
+//     arrow 0 1
+//
+// Shapes are rectangle, rhombus, parallelogram, ellipse and circle, followed by their bounds and
+// text. Bounds are finite, within +-max_diagram_coordinate, and have no negative size. Arrows
+// connect two different shapes, which they refer to by their zero based position in the
+// description. Empty lines and lines starting with # are ignored. On failure, error gets a message
+// with the line number.
+std::optional<diagram> read_diagram(std::string_view description, std::string& error)
+{
+    std::optional<diagram> result;
+    std::vector<item_id> ids;
+    size_t line_number = 0;
+
+    const auto fail = [&](std::string_view message)
+    {
+        error = "line " + std::to_string(line_number) + ": " + std::string{message};
+        return std::nullopt;
+    };
+
+    while (!description.empty())
+    {
+        const auto end = description.find('\n');
+        std::istringstream stream{std::string{description.substr(0, end)}};
+        description.remove_prefix(end == std::string_view::npos ? description.size() : end + 1);
+        ++line_number;
+
+        std::string kind;
+
+        if (!(stream >> kind) || kind[0] == '#')
+            continue;
+
+        std::string text;
+
+        if (kind == "title")
+        {
+            if (result)
+                return fail("the title must come first");
+
+            std::getline(stream >> std::ws, text);
+            result.emplace(text);
+            continue;
+        }
+
+        if (!result)
+            result.emplace();
+
+        if (kind == "arrow")
+        {
+            size_t source{};
+            size_t target{};
+
+            if (!(stream >> source >> target))
+                return fail("expected: arrow <source> <target>");
+
+            if (source >= ids.size() || target >= ids.size())
+                return fail("arrow refers to an unknown shape");
+
+            if (source == target)
+                return fail("arrow must connect two different shapes");
+
+            result->add_item(line{ids[source], ids[target], line_kind::filled_arrow});
+            continue;
+        }
+
+        if (kind != "rectangle" && kind != "rhombus" && kind != "parallelogram" && kind != "ellipse" && kind != "circle")
+            return fail("unknown item '" + kind + "'");
+
+        jg::rect bounds;
+
+        if (!(stream >> bounds.x >> bounds.y >> bounds.width >> bounds.height))
+            return fail("expected: " + kind + " <x> <y> <width> <height> <text>");
+
+        for (const float value : {bounds.x, bounds.y, bounds.x + bounds.width, bounds.y + bounds.height})
+        {
+            if (!std::isfinite(value) || std::abs(value) > max_diagram_coordinate)
+                return fail("bounds must lie within +-" + std::to_string(static_cast<int>(max_diagram_coordinate)));
+        }
+
+        if (bounds.width < 0 || bounds.height < 0)
+            return fail("width and height must not be negative");
+
+        std::getline(stream >> std::ws, text);
+
+        if (kind == "rectangle")          ids.push_back(result->add_item(rectangle{bounds, text}));
+        else if (kind == "rhombus")       ids.push_back(result->add_item(rhombus{bounds, text}));
+        else if (kind == "parallelogram") ids.push_back(result->add_item(parallelogram{bounds, text}));
+        else if (kind == "ellipse")       ids.push_back(result->add_item(ellipse{bounds, text}));
+        else                              ids.push_back(result->add_item(circle{bounds, text}));
+    }
+
+    if (!result)
+        result.emplace();
+
+    return result;
+}
+
+} // namespace jg
@@ -0,0 +1,482 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include "jg_bitmap_font.h"
+#include "jg_coordinates.h"
+#include "jg_rasterizer.h"
+#include "jg_svg_writer.h"
+
+namespace jg
+{
+
+// Renders the same vocabulary as svg_writer into an anti-aliased RGBA framebuffer, which finish()
+// writes as a PNG image. Text is drawn with the embedded bitmap font, so it has the size and
+// placement of the SVG text but not its typeface. Comments have nothing to render.
+class png_writer final
+{
+public:
+    // The scale maps user units to output pixels, like svg_writer's; everything is written in user
+    // units and scaled when it's rendered.
+    png_writer(std::ostream& stream, jg::size size, unsigned thread_count = std::thread::hardware_concurrency(), float scale = 1)
+        : m_stream{stream}
+        , m_size{size}
+        , m_thread_count{std::max(thread_count, 1u)}
+        , m_scale{scale}
+    {}
+
+    png_writer(const png_writer&) = delete;
+    png_writer& operator=(const png_writer&) = delete;
+
+    // Rasterizes everything written so far. The image is at least 1x1, since PNG has no empty images.
+    framebuffer render() const
+    {
+        framebuffer image{std::max(static_cast<int>(std::ceil(m_size.width * m_scale)), 1),
+                          std::max(static_cast<int>(std::ceil(m_size.height * m_scale)), 1)};
+
+        if (m_scale == 1)
+            m_rasterizer.render(image, m_thread_count);
+        else
+            m_rasterizer.scaled(m_scale).render(image, m_thread_count);
+
+        return image;
+    }
+
+    void finish()
+    {
+        write_png(render());
+    }
+
+    void write_background(std::string_view color = "white")
+    {
+        m_target->fill(raster_polygon{corners({0, 0, m_size.width, m_size.height})}, to_rgba(color));
+    }
+
+    void write_grid(float distance, std::string_view color = "whitesmoke")
+    {
+        for (float f = distance; f < m_size.width; f += distance)
+            write_line({f, 0}, {f, m_size.height}, {"none", std::string(color), "1"});
+
+        for (float f = distance; f < m_size.height; f += distance)
+            write_line({0, f}, {m_size.width, f}, {"none", std::string(color), "1"});
+    }
+
+    void write_title(std::string_view title)
+    {
+        // Same placement as svg_writer's title.
+        constexpr float font_size = 25;
+        svg_text_attributes attributes;
+        attributes.font.size = m_format.to_string(font_size);
+        attributes.text_anchor = svg_text_anchor::start;
+        attributes.dominant_baseline = svg_dominant_baseline::middle;
+
+        write_text({font_size / 2, font_size}, title, attributes);
+    }
+
+    void write_border()
+    {
+        m_target->stroke_polygon(corners({0, 0, m_size.width, m_size.height}), 1, false, to_rgba("black"));
+    }
+
+    void write_line(jg::point point1, jg::point point2, const svg_paint_attributes& attributes)
+    {
+        m_target->stroke_line(point1, point2, stroke_width(attributes), to_rgba(attributes.stroke));
+    }
+
+    // An arrow without length has no direction to point in, and isn't drawn.
+    void write_arrow(jg::point point1, jg::point point2, const svg_paint_attributes& attributes)
+    {
+        const float dx = point2.x - point1.x;
+        const float dy = point2.y - point1.y;
+        const float distance = std::hypotf(dx, dy);
+
+        if (!(distance > 0))
+            return;
+
+        const float ddx = m_arrowhead_length * dx / distance;
+        const float ddy = m_arrowhead_length * dy / distance;
+        const jg::point base{point2.x - ddx, point2.y - ddy};
+
+        m_target->stroke_line(point1, base, stroke_width(attributes), to_rgba(attributes.stroke));
+
+        // Same geometry as svg_writer's arrowhead marker, which is filled black.
+        m_target->fill(raster_polygon{{{base.x - ddy / 2, base.y + ddx / 2},
+                                          point2,
+                                          {base.x + ddy / 2, base.y - ddx / 2}}},
+                          to_rgba("black"));
+    }
+
+    void write_rect(jg::rect rect, const svg_paint_attributes& attributes)
+    {
+        m_target->fill(raster_polygon{corners(rect)}, to_rgba(attributes.fill));
+        m_target->stroke_polygon(corners(rect), stroke_width(attributes), false, to_rgba(attributes.stroke));
+    }
+
+    void write_rhombus(jg::rect rect, const svg_paint_attributes& attributes)
+    {
+        const std::vector<jg::point> points
+        {
+            {rect.x                 , rect.y + rect.height / 2},
+            {rect.x + rect.width / 2, rect.y},
+            {rect.x + rect.width    , rect.y + rect.height / 2},
+            {rect.x + rect.width / 2, rect.y + rect.height}
+        };
+
+        m_target->fill(raster_polygon{points}, to_rgba(attributes.fill));
+        m_target->stroke_polygon(points, stroke_width(attributes), true, to_rgba(attributes.stroke));
+    }
+
+    void write_parallelogram(jg::rect rect, const svg_paint_attributes& attributes)
+    {
+        const std::vector<jg::point> points
+        {
+            {rect.x + rect.height             , rect.y},
+            {rect.x + rect.width              , rect.y},
+            {rect.x + rect.width - rect.height, rect.y + rect.height},
+            {rect.x                           , rect.y + rect.height}
+        };
+
+        m_target->fill(raster_polygon{points}, to_rgba(attributes.fill));
+        m_target->stroke_polygon(points, stroke_width(attributes), true, to_rgba(attributes.stroke));
+    }
+
+    // Glyphs are seven units tall above the baseline at a unit of a tenth of the font size, which
+    // is about the cap height of a sans-serif font; text is aligned on that height. Once a glyph
+    // pixel covers at least an output pixel, every pixel run of a glyph row is snapped to whole
+    // output pixels, so that runs meeting each other don't leave anti-aliased seams. Smaller glyphs
+    // are left to anti-aliasing, which keeps all of their rows.
+    void write_text(jg::point point, std::string_view text, const svg_text_attributes& attributes)
+    {
+        const float font_size = attributes.font.size.empty() ? 0.0f : std::stof(attributes.font.size);
+
+        if (!(font_size > 0))
+            return;
+
+        // One glyph per UTF-8 code point; continuation bytes don't start one.
+        std::vector<unsigned char> characters;
+
+        for (const char c : text)
+            if ((static_cast<unsigned char>(c) & 0xc0) != 0x80)
+                characters.push_back(static_cast<unsigned char>(c));
+
+        if (characters.empty())
+            return;
+
+        const float unit = font_size / 10;
+        const float width = static_cast<float>(static_cast<int>(characters.size()) * glyph_advance - (glyph_advance - glyph_width)) * unit;
+        const float height = glyph_height * unit;
+
+        float left = point.x;
+        float top = point.y;
+
+        if (attributes.text_anchor == svg_text_anchor::middle)
+            left -= width / 2;
+        else if (attributes.text_anchor == svg_text_anchor::end)
+            left -= width;
+
+        if (attributes.dominant_baseline == svg_dominant_baseline::middle)
+            top -= height / 2;
+        else if (attributes.dominant_baseline == svg_dominant_baseline::baseline)
+            top -= height;
+
+        const bool snapped = unit * m_scale >= 1;
+        const auto snap = [&](float origin, int units)
+        {
+            const float position = origin + static_cast<float>(units) * unit;
+            return snapped ? std::round(position * m_scale) / m_scale : position;
+        };
+
+        const rgba color = to_rgba(attributes.paint.fill.empty() ? "black" : attributes.paint.fill);
+
+        for (size_t i = 0; i < characters.size(); ++i)
+        {
+            const auto& rows = glyph(characters[i]);
+            const int column = static_cast<int>(i) * glyph_advance;
+
+            for (int row = 0; row < glyph_height + glyph_descent; ++row)
+            {
+                const auto set = [&](int x) { return x < glyph_width && (rows[static_cast<size_t>(row)] & (0x10 >> x)) != 0; };
+
+                for (int x = 0; x < glyph_width; ++x)
+                {
+                    if (!set(x))
+                        continue;
+
+                    const int begin = x;
+
+                    while (set(x + 1))
+                        ++x;
+
+                    const float x1 = snap(left, column + begin);
+                    const float x2 = snap(left, column + x + 1);
+                    const float y1 = snap(top, row);
+                    const float y2 = snap(top, row + 1);
+
+                    if (x2 > x1 && y2 > y1)
+                        m_target->fill(raster_polygon{corners({x1, y1, x2 - x1, y2 - y1})}, color);
+                }
+            }
+        }
+    }
+
+    void write_circle(jg::point point, float radius, const svg_paint_attributes& attributes)
+    {
+        write_ellipse(point, radius, radius, attributes);
+    }
+
+    void write_ellipse(jg::point point, float xradius, float yradius, const svg_paint_attributes& attributes)
+    {
+        m_target->fill(raster_ellipse{point, xradius, yradius}, to_rgba(attributes.fill));
+        m_target->stroke_ellipse(point, xradius, yradius, stroke_width(attributes), to_rgba(attributes.stroke));
+    }
+
+    void write_comment(std::string_view)
+    {}
+
+    // How numbers in attributes are written, which is how write_text gets its font size.
+    const svg_number_format& number_format() const
+    {
+        return m_format;
+    }
+
+    void begin_symbol(std::string_view id)
+    {
+        m_target = &m_symbols[std::string{id}];
+    }
+
+    void end_symbol()
+    {
+        m_target = &m_rasterizer;
+    }
+
+    void write_use(std::string_view id, jg::point point)
+    {
+        const auto symbol = m_symbols.find(std::string{id});
+        verify(symbol != m_symbols.end());
+        m_target->draw(symbol->second, point);
+    }
+
+private:
+    static std::vector<jg::point> corners(jg::rect rect)
+    {
+        return {{rect.x, rect.y},
+                {rect.x + rect.width, rect.y},
+                {rect.x + rect.width, rect.y + rect.height},
+                {rect.x, rect.y + rect.height}};
+    }
+
+    static float stroke_width(const svg_paint_attributes& attributes)
+    {
+        return attributes.stroke_width.empty() ? 0.0f : std::stof(attributes.stroke_width);
+    }
+
+    void write_png(const framebuffer& image)
+    {
+        // Scanlines with filter type 0 (none) in front of each row.
+        std::vector<std::uint8_t> scanlines;
+        scanlines.reserve(static_cast<size_t>(image.height()) * (static_cast<size_t>(image.width()) * 4 + 1));
+
+        for (int y = 0; y < image.height(); ++y)
+        {
+            scanlines.push_back(0);
+
+            for (const rgba* pixel = image.row(y); pixel != image.row(y) + image.width(); ++pixel)
+                scanlines.insert(scanlines.end(), {pixel->r, pixel->g, pixel->b, pixel->a});
+        }
+
+        m_stream.write("\x89PNG\r\n\x1a\n", 8);
+
+        std::vector<std::uint8_t> header;
+        append_u32(header, static_cast<std::uint32_t>(image.width()));
+        append_u32(header, static_cast<std::uint32_t>(image.height()));
+        header.insert(header.end(), {8, 6, 0, 0, 0}); // 8 bit RGBA, deflate, no interlace
+        write_chunk("IHDR", header);
+
+        write_chunk("IDAT", zlib_compress(scanlines, static_cast<size_t>(image.width()) * 4 + 1));
+        write_chunk("IEND", {});
+    }
+
+    void write_chunk(const char (&type)[5], const std::vector<std::uint8_t>& data)
+    {
+        std::vector<std::uint8_t> chunk;
+        append_u32(chunk, static_cast<std::uint32_t>(data.size()));
+        chunk.insert(chunk.end(), type, type + 4);
+        chunk.insert(chunk.end(), data.begin(), data.end());
+        append_u32(chunk, crc32(chunk.data() + 4, chunk.size() - 4));
+
+        m_stream.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+    }
+
+    static void append_u32(std::vector<std::uint8_t>& data, std::uint32_t value)
+    {
+        data.insert(data.end(), {static_cast<std::uint8_t>(value >> 24), static_cast<std::uint8_t>(value >> 16),
+                                 static_cast<std::uint8_t>(value >> 8), static_cast<std::uint8_t>(value)});
+    }
+
+    static std::uint32_t crc32(const std::uint8_t* data, size_t size)
+    {
+        static const auto table = []
+        {
+            std::array<std::uint32_t, 256> result{};
+
+            for (std::uint32_t n = 0; n < 256; ++n)
+            {
+                std::uint32_t c = n;
+
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+                result[n] = c;
+            }
+
+            return result;
+        }();
+
+        std::uint32_t crc = 0xffffffffu;
+
+        for (size_t i = 0; i < size; ++i)
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+
+        return crc ^ 0xffffffffu;
+    }
+
+    static std::uint32_t adler32(const std::vector<std::uint8_t>& data)
+    {
+        std::uint32_t a = 1;
+        std::uint32_t b = 0;
+
+        for (auto byte : data)
+        {
+            a = (a + byte) % 65521;
+            b = (b + a) % 65521;
+        }
+
+        return (b << 16) | a;
+    }
+
+    // A single fixed Huffman deflate block. Diagrams are mostly flat color, so looking for repeats
+    // of the previous pixel and of the row above is enough to compress them well.
+    static std::vector<std::uint8_t> zlib_compress(const std::vector<std::uint8_t>& data, size_t stride)
+    {
+        std::vector<std::uint8_t> result{0x78, 0x01};
+        std::uint32_t bits = 0;
+        int bit_count = 0;
+
+        const auto write_bits = [&](std::uint32_t value, int count)
+        {
+            bits |= value << bit_count;
+            bit_count += count;
+
+            while (bit_count >= 8)
+            {
+                result.push_back(static_cast<std::uint8_t>(bits));
+                bits >>= 8;
+                bit_count -= 8;
+            }
+        };
+
+        // Huffman codes are packed starting with their most significant bit.
+        const auto write_code = [&](std::uint32_t code, int length)
+        {
+            std::uint32_t reversed = 0;
+
+            for (int i = 0; i < length; ++i)
+                reversed |= ((code >> i) & 1) << (length - 1 - i);
+
+            write_bits(reversed, length);
+        };
+
+        const auto write_symbol = [&](int symbol)
+        {
+            if (symbol < 144)      write_code(static_cast<std::uint32_t>(0x30 + symbol), 8);
+            else if (symbol < 256) write_code(static_cast<std::uint32_t>(0x190 + symbol - 144), 9);
+            else if (symbol < 280) write_code(static_cast<std::uint32_t>(symbol - 256), 7);
+            else                   write_code(static_cast<std::uint32_t>(0xc0 + symbol - 280), 8);
+        };
+
+        static constexpr std::array<int, 29> length_base{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static constexpr std::array<int, 29> length_extra{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static constexpr std::array<int, 30> distance_base{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static constexpr std::array<int, 30> distance_extra{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        const auto write_match = [&](int length, int distance)
+        {
+            size_t l = length_base.size() - 1;
+            while (length_base[l] > length) --l;
+            write_symbol(257 + static_cast<int>(l));
+            write_bits(static_cast<std::uint32_t>(length - length_base[l]), length_extra[l]);
+
+            size_t d = distance_base.size() - 1;
+            while (distance_base[d] > distance) --d;
+            write_code(static_cast<std::uint32_t>(d), 5);
+            write_bits(static_cast<std::uint32_t>(distance - distance_base[d]), distance_extra[d]);
+        };
+
+        write_bits(1, 1); // final block
+        write_bits(1, 2); // fixed Huffman codes
+
+        const size_t up = stride <= 32768 ? stride : 0;
+        size_t i = 0;
+
+        while (i < data.size())
+        {
+            size_t best_length = 0;
+            size_t best_distance = 0;
+
+            for (size_t distance : {size_t{4}, up})
+            {
+                if (distance == 0 || distance > i)
+                    continue;
+
+                size_t length = 0;
+
+                while (length < 258 && i + length < data.size() && data[i + length] == data[i + length - distance])
+                    ++length;
+
+                if (length > best_length)
+                {
+                    best_length = length;
+                    best_distance = distance;
+                }
+            }
+
+            if (best_length >= 3)
+            {
+                write_match(static_cast<int>(best_length), static_cast<int>(best_distance));
+                i += best_length;
+            }
+            else
+            {
+                write_symbol(data[i]);
+                ++i;
+            }
+        }
+
+        write_symbol(256);
+
+        if (bit_count > 0)
+            write_bits(0, 8 - bit_count);
+
+        append_u32(result, adler32(data));
+
+        return result;
+    }
+
+    std::ostream& m_stream;
+    jg::size m_size;
+    unsigned m_thread_count{};
+    float m_scale{};
+    rasterizer m_rasterizer;
+    std::map<std::string, rasterizer> m_symbols;
+    rasterizer* m_target{&m_rasterizer};
+    svg_number_format m_format;
+    float m_arrowhead_length{20.0f};
+};
+
+} // namespace jg
@@ -0,0 +1,599 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include <jg_verify.h>
+#include "jg_coordinates.h"
+
+namespace jg
+{
+
+struct rgba final
+{
+    std::uint8_t r{};
+    std::uint8_t g{};
+    std::uint8_t b{};
+    std::uint8_t a{};
+};
+
+bool operator==(rgba lhs, rgba rhs)
+{
+    return lhs.r == rhs.r && lhs.g == rhs.g && lhs.b == rhs.b && lhs.a == rhs.a;
+}
+
+bool operator!=(rgba lhs, rgba rhs)
+{
+    return !(lhs == rhs);
+}
+
+// Parses the subset of SVG paint values that svg_writer users pass: "#rgb", "#rrggbb" and a few
+// named colors. "none" and "transparent" give a fully transparent color.
+rgba to_rgba(std::string_view color)
+{
+    const auto hex = [](char c) -> std::uint8_t
+    {
+        if (c >= '0' && c <= '9') return static_cast<std::uint8_t>(c - '0');
+        if (c >= 'a' && c <= 'f') return static_cast<std::uint8_t>(c - 'a' + 10);
+        if (c >= 'A' && c <= 'F') return static_cast<std::uint8_t>(c - 'A' + 10);
+        verify(false);            return 0;
+    };
+
+    if (color.size() == 7 && color[0] == '#')
+        return {static_cast<std::uint8_t>(hex(color[1]) * 16 + hex(color[2])),
+                static_cast<std::uint8_t>(hex(color[3]) * 16 + hex(color[4])),
+                static_cast<std::uint8_t>(hex(color[5]) * 16 + hex(color[6])),
+                255};
+
+    if (color.size() == 4 && color[0] == '#')
+        return {static_cast<std::uint8_t>(hex(color[1]) * 17),
+                static_cast<std::uint8_t>(hex(color[2]) * 17),
+                static_cast<std::uint8_t>(hex(color[3]) * 17),
+                255};
+
+    if (color.empty() || color == "none" || color == "transparent") return {0, 0, 0, 0};
+    if (color == "black")      return {0, 0, 0, 255};
+    if (color == "white")      return {255, 255, 255, 255};
+    if (color == "whitesmoke") return {245, 245, 245, 255};
+    if (color == "red")        return {255, 0, 0, 255};
+    if (color == "green")      return {0, 128, 0, 255};
+    if (color == "blue")       return {0, 0, 255, 255};
+    if (color == "gray")       return {128, 128, 128, 255};
+
+    verify(false);
+    return {0, 0, 0, 0};
+}
+
+class framebuffer final
+{
+public:
+    framebuffer(int width, int height)
+        : m_width{width}
+        , m_height{height}
+        , m_pixels(static_cast<size_t>(width) * static_cast<size_t>(height))
+    {}
+
+    int width() const
+    {
+        return m_width;
+    }
+
+    int height() const
+    {
+        return m_height;
+    }
+
+    rgba* row(int y)
+    {
+        return m_pixels.data() + static_cast<size_t>(y) * static_cast<size_t>(m_width);
+    }
+
+    const rgba* row(int y) const
+    {
+        return m_pixels.data() + static_cast<size_t>(y) * static_cast<size_t>(m_width);
+    }
+
+private:
+    int m_width{};
+    int m_height{};
+    std::vector<rgba> m_pixels;
+};
+
+// Pixel coverage is 0..255. Pixels on region edges are sampled on a 4x4 grid, pixels that are
+// trivially inside or outside are resolved without sampling.
+constexpr int raster_samples = 4;
+
+class raster_polygon final
+{
+public:
+    // The polygon must be convex; it may be wound either way.
+    raster_polygon(std::vector<jg::point> points)
+        : m_points{std::move(points)}
+    {
+        float area = 0;
+
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            const auto& p1 = m_points[i];
+            const auto& p2 = m_points[(i + 1) % m_points.size()];
+            area += p1.x * p2.y - p2.x * p1.y;
+        }
+
+        const float sign = area < 0 ? -1.0f : 1.0f;
+
+        for (size_t i = 0; i < m_points.size(); ++i)
+        {
+            const auto& p1 = m_points[i];
+            const auto& p2 = m_points[(i + 1) % m_points.size()];
+            const float a = sign * (p1.y - p2.y);
+            const float b = sign * (p2.x - p1.x);
+            m_edges.push_back({a, b, -(a * p1.x + b * p1.y)});
+        }
+    }
+
+    const std::vector<jg::point>& points() const
+    {
+        return m_points;
+    }
+
+    raster_polygon translated(jg::point offset) const
+    {
+        std::vector<jg::point> points{m_points};
+
+        for (auto& point : points)
+            point = {point.x + offset.x, point.y + offset.y};
+
+        return {std::move(points)};
+    }
+
+    raster_polygon scaled(float factor) const
+    {
+        std::vector<jg::point> points{m_points};
+
+        for (auto& point : points)
+            point = {point.x * factor, point.y * factor};
+
+        return {std::move(points)};
+    }
+
+    jg::rect bounds() const
+    {
+        if (m_points.empty())
+            return {};
+
+        auto [min_x, max_x] = std::minmax_element(m_points.begin(), m_points.end(), [](auto& l, auto& r) { return l.x < r.x; });
+        auto [min_y, max_y] = std::minmax_element(m_points.begin(), m_points.end(), [](auto& l, auto& r) { return l.y < r.y; });
+
+        return {min_x->x, min_y->y, max_x->x - min_x->x, max_y->y - min_y->y};
+    }
+
+    std::uint8_t coverage(float x, float y) const
+    {
+        if (m_edges.empty())
+            return 0;
+
+        bool inside = true;
+
+        // The edge functions are linear, so their extremes over the pixel square are at its corners.
+        for (const auto& edge : m_edges)
+        {
+            const float value = edge.a * x + edge.b * y + edge.c;
+
+            if (value + std::max(edge.a, 0.0f) + std::max(edge.b, 0.0f) < 0)
+                return 0;
+
+            if (value + std::min(edge.a, 0.0f) + std::min(edge.b, 0.0f) < 0)
+                inside = false;
+        }
+
+        if (inside)
+            return 255;
+
+        int count = 0;
+
+        for (int sy = 0; sy < raster_samples; ++sy)
+        {
+            for (int sx = 0; sx < raster_samples; ++sx)
+            {
+                const float px = x + (static_cast<float>(sx) + 0.5f) / raster_samples;
+                const float py = y + (static_cast<float>(sy) + 0.5f) / raster_samples;
+
+                count += std::all_of(m_edges.begin(), m_edges.end(), [&](const auto& edge)
+                {
+                    return edge.a * px + edge.b * py + edge.c >= 0;
+                });
+            }
+        }
+
+        return static_cast<std::uint8_t>(count * 255 / (raster_samples * raster_samples));
+    }
+
+private:
+    struct edge final
+    {
+        float a{};
+        float b{};
+        float c{};
+    };
+
+    std::vector<jg::point> m_points;
+    std::vector<edge> m_edges;
+};
+
+class raster_ellipse final
+{
+public:
+    raster_ellipse(jg::point center, float xradius, float yradius)
+        : m_center{center}
+        , m_xradius{std::max(xradius, 0.0f)}
+        , m_yradius{std::max(yradius, 0.0f)}
+    {}
+
+    raster_ellipse translated(jg::point offset) const
+    {
+        return {{m_center.x + offset.x, m_center.y + offset.y}, m_xradius, m_yradius};
+    }
+
+    raster_ellipse scaled(float factor) const
+    {
+        return {{m_center.x * factor, m_center.y * factor}, m_xradius * factor, m_yradius * factor};
+    }
+
+    jg::rect bounds() const
+    {
+        return {m_center.x - m_xradius, m_center.y - m_yradius, m_xradius * 2, m_yradius * 2};
+    }
+
+    std::uint8_t coverage(float x, float y) const
+    {
+        if (m_xradius <= 0 || m_yradius <= 0)
+            return 0;
+
+        // In unit circle space the pixel is an axis aligned box; its point closest to the origin
+        // decides if it's fully outside, its corner furthest away decides if it's fully inside.
+        const float x1 = (x - m_center.x) / m_xradius;
+        const float x2 = (x + 1 - m_center.x) / m_xradius;
+        const float y1 = (y - m_center.y) / m_yradius;
+        const float y2 = (y + 1 - m_center.y) / m_yradius;
+
+        const float near_x = std::clamp(0.0f, x1, x2);
+        const float near_y = std::clamp(0.0f, y1, y2);
+
+        if (near_x * near_x + near_y * near_y > 1)
+            return 0;
+
+        const float far_x = std::max(x1 * x1, x2 * x2);
+        const float far_y = std::max(y1 * y1, y2 * y2);
+
+        if (far_x + far_y <= 1)
+            return 255;
+
+        int count = 0;
+
+        for (int sy = 0; sy < raster_samples; ++sy)
+        {
+            for (int sx = 0; sx < raster_samples; ++sx)
+            {
+                const float px = (x + (static_cast<float>(sx) + 0.5f) / raster_samples - m_center.x) / m_xradius;
+                const float py = (y + (static_cast<float>(sy) + 0.5f) / raster_samples - m_center.y) / m_yradius;
+                count += px * px + py * py <= 1;
+            }
+        }
+
+        return static_cast<std::uint8_t>(count * 255 / (raster_samples * raster_samples));
+    }
+
+private:
+    jg::point m_center;
+    float m_xradius{};
+    float m_yradius{};
+};
+
+using raster_region = std::variant<std::monostate, raster_polygon, raster_ellipse>;
+
+// A painted area is the outer region minus the optional inner region, which must lie inside the
+// outer one. That's enough to express both fills (no inner region) and strokes of convex outlines.
+struct raster_command final
+{
+    raster_region outer;
+    raster_region inner;
+    rgba color;
+};
+
+class rasterizer final
+{
+public:
+    void fill(raster_region region, rgba color)
+    {
+        if (color.a == 0)
+            return;
+
+        m_commands.push_back({std::move(region), std::monostate{}, color});
+    }
+
+    void fill(raster_region outer, raster_region inner, rgba color)
+    {
+        if (color.a == 0)
+            return;
+
+        m_commands.push_back({std::move(outer), std::move(inner), color});
+    }
+
+    // A polygon stroke painted as its outward offset minus its inward offset. The outward offset
+    // gets a miter or bevel join at each corner.
+    void stroke_polygon(const std::vector<jg::point>& points, float width, bool bevel, rgba color)
+    {
+        if (width <= 0 || points.size() < 3)
+            return;
+
+        auto inner = offset_polygon(points, -width / 2, false);
+
+        // A stroke wider than the shape leaves no inside; the inward offset turns itself inside out,
+        // which shows as edges pointing the opposite way of the ones they were offset from.
+        if (reverses_edges(points, inner))
+            fill(raster_polygon{offset_polygon(points, width / 2, bevel)}, color);
+        else
+            fill(offset_polygon(points, width / 2, bevel), std::move(inner), color);
+    }
+
+    // A line segment stroke with butt caps.
+    void stroke_line(jg::point point1, jg::point point2, float width, rgba color)
+    {
+        const float dx = point2.x - point1.x;
+        const float dy = point2.y - point1.y;
+        const float length = std::hypotf(dx, dy);
+
+        if (width <= 0 || length <= 0)
+            return;
+
+        const float nx = -dy / length * width / 2;
+        const float ny = dx / length * width / 2;
+
+        fill(raster_polygon{{{point1.x + nx, point1.y + ny},
+                             {point2.x + nx, point2.y + ny},
+                             {point2.x - nx, point2.y - ny},
+                             {point1.x - nx, point1.y - ny}}}, color);
+    }
+
+    void stroke_ellipse(jg::point center, float xradius, float yradius, float width, rgba color)
+    {
+        if (width <= 0)
+            return;
+
+        fill(raster_ellipse{center, xradius + width / 2, yradius + width / 2},
+             raster_ellipse{center, xradius - width / 2, yradius - width / 2},
+             color);
+    }
+
+    // Appends all commands of another rasterizer, moved by the given offset.
+    void draw(const rasterizer& other, jg::point offset)
+    {
+        for (const auto& command : other.m_commands)
+            m_commands.push_back({translated(command.outer, offset), translated(command.inner, offset), command.color});
+    }
+
+    // All commands with their coordinates multiplied by the factor, for rendering at another scale.
+    rasterizer scaled(float factor) const
+    {
+        rasterizer result;
+
+        for (const auto& command : m_commands)
+            result.m_commands.push_back({scaled(command.outer, factor), scaled(command.inner, factor), command.color});
+
+        return result;
+    }
+
+    // The framebuffer is split into horizontal bands, one per thread. Every thread paints all
+    // commands in order, clipped to its own band, so no two threads ever touch the same pixel.
+    void render(framebuffer& target, unsigned thread_count) const
+    {
+        const int band_count = std::clamp(static_cast<int>(thread_count), 1, std::max(target.height(), 1));
+        const int band_height = (target.height() + band_count - 1) / band_count;
+
+        std::vector<std::thread> threads;
+
+        for (int band = 1; band < band_count; ++band)
+            threads.emplace_back([&, band] { render_band(target, band * band_height, std::min((band + 1) * band_height, target.height())); });
+
+        render_band(target, 0, std::min(band_height, target.height()));
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+private:
+    static bool reverses_edges(const std::vector<jg::point>& points, const std::vector<jg::point>& offset)
+    {
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& p1 = points[i];
+            const auto& p2 = points[(i + 1) % points.size()];
+            const auto& o1 = offset[i];
+            const auto& o2 = offset[(i + 1) % offset.size()];
+
+            if ((p2.x - p1.x) * (o2.x - o1.x) + (p2.y - p1.y) * (o2.y - o1.y) <= 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    static float signed_area(const std::vector<jg::point>& points)
+    {
+        float area = 0;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& p1 = points[i];
+            const auto& p2 = points[(i + 1) % points.size()];
+            area += p1.x * p2.y - p2.x * p1.y;
+        }
+
+        return area / 2;
+    }
+
+    static std::vector<jg::point> offset_polygon(const std::vector<jg::point>& points, float distance, bool bevel)
+    {
+        // Outward edge normals, scaled to the offset distance.
+        const float sign = signed_area(points) < 0 ? -1.0f : 1.0f;
+        std::vector<jg::point> normals;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& p1 = points[i];
+            const auto& p2 = points[(i + 1) % points.size()];
+            const float length = std::max(std::hypotf(p2.x - p1.x, p2.y - p1.y), 1e-6f);
+            normals.push_back({sign * (p2.y - p1.y) / length * distance, -sign * (p2.x - p1.x) / length * distance});
+        }
+
+        std::vector<jg::point> result;
+
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            const auto& point = points[i];
+            const auto& previous = normals[(i + points.size() - 1) % points.size()];
+            const auto& next = normals[i];
+
+            if (bevel)
+            {
+                result.push_back({point.x + previous.x, point.y + previous.y});
+                result.push_back({point.x + next.x, point.y + next.y});
+            }
+            else
+            {
+                // The miter point is where the two offset edges meet.
+                const float scale = distance * distance / std::max(distance * distance + previous.x * next.x + previous.y * next.y, 1e-6f);
+                result.push_back({point.x + (previous.x + next.x) * scale, point.y + (previous.y + next.y) * scale});
+            }
+        }
+
+        return result;
+    }
+
+    static raster_region translated(const raster_region& region, jg::point offset)
+    {
+        return std::visit([&](const auto& shape) -> raster_region
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(shape)>, std::monostate>)
+                return shape;
+            else
+                return shape.translated(offset);
+        }, region);
+    }
+
+    static raster_region scaled(const raster_region& region, float factor)
+    {
+        return std::visit([&](const auto& shape) -> raster_region
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(shape)>, std::monostate>)
+                return shape;
+            else
+                return shape.scaled(factor);
+        }, region);
+    }
+
+    static jg::rect bounds(const raster_region& region)
+    {
+        return std::visit([](const auto& shape)
+        {
+            if constexpr (std::is_same_v<std::decay_t<decltype(shape)>, std::monostate>)
+                return jg::rect{};
+            else
+                return shape.bounds();
+        }, region);
+    }
+
+    static void coverage_span(const raster_region& region, float y, int x1, int x2, std::uint8_t* coverage, bool subtract)
+    {
+        std::visit([&](const auto& shape)
+        {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(shape)>, std::monostate>)
+            {
+                for (int x = x1; x < x2; ++x)
+                {
+                    const auto value = shape.coverage(static_cast<float>(x), y);
+                    auto& result = coverage[x - x1];
+                    result = subtract ? static_cast<std::uint8_t>(result > value ? result - value : 0) : value;
+                }
+            }
+        }, region);
+    }
+
+    // Fully covered runs of an opaque color are plain fills, everything else is blended.
+    static void blend_span(rgba* pixels, const std::uint8_t* coverage, int count, rgba color)
+    {
+        int x = 0;
+
+        while (x < count)
+        {
+            if (color.a == 255 && coverage[x] == 255)
+            {
+                int end = x + 1;
+
+                while (end < count && coverage[end] == 255)
+                    ++end;
+
+                std::fill(pixels + x, pixels + end, color);
+                x = end;
+                continue;
+            }
+
+            if (coverage[x] != 0)
+                pixels[x] = blend(pixels[x], color, coverage[x]);
+
+            ++x;
+        }
+    }
+
+    static rgba blend(rgba target, rgba color, std::uint8_t coverage)
+    {
+        const float source_alpha = static_cast<float>(color.a) * static_cast<float>(coverage) / (255.0f * 255.0f);
+        const float target_alpha = static_cast<float>(target.a) / 255.0f * (1 - source_alpha);
+        const float alpha = source_alpha + target_alpha;
+
+        if (alpha <= 0)
+            return {0, 0, 0, 0};
+
+        const auto channel = [&](std::uint8_t source, std::uint8_t destination)
+        {
+            const float value = (static_cast<float>(source) * source_alpha + static_cast<float>(destination) * target_alpha) / alpha;
+            return static_cast<std::uint8_t>(std::lround(std::clamp(value, 0.0f, 255.0f)));
+        };
+
+        return {channel(color.r, target.r), channel(color.g, target.g), channel(color.b, target.b),
+                static_cast<std::uint8_t>(std::lround(alpha * 255))};
+    }
+
+    void render_band(framebuffer& target, int y1, int y2) const
+    {
+        std::vector<std::uint8_t> coverage(static_cast<size_t>(target.width()));
+
+        for (const auto& command : m_commands)
+        {
+            const auto area = bounds(command.outer);
+            const int x_begin = std::max(static_cast<int>(std::floor(area.x)), 0);
+            const int x_end = std::min(static_cast<int>(std::ceil(area.x + area.width)), target.width());
+            const int y_begin = std::max(static_cast<int>(std::floor(area.y)), y1);
+            const int y_end = std::min(static_cast<int>(std::ceil(area.y + area.height)), y2);
+
+            if (x_begin >= x_end)
+                continue;
+
+            for (int y = y_begin; y < y_end; ++y)
+            {
+                coverage_span(command.outer, static_cast<float>(y), x_begin, x_end, coverage.data(), false);
+                coverage_span(command.inner, static_cast<float>(y), x_begin, x_end, coverage.data(), true);
+                blend_span(target.row(y) + x_begin, coverage.data(), x_end - x_begin, command.color);
+            }
+        }
+    }
+
+    std::vector<raster_command> m_commands;
+};
+
+} // namespace jg
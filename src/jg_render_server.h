@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+#include "jg_diagram_reader.h"
+
+namespace jg
+{
+
+// Renders diagram descriptions (see read_diagram) to SVG for as long as the input stream lasts,
+// so that a client pays for process startup once instead of once per diagram.
+//
+// Requests are framed as a line with the byte count of the description, followed by that many
+// bytes. Each response is a line with "ok" or "error" and the byte count of its body, followed by
+// the body: the SVG document or an error message. Responses come in request order. A request
+// larger than max_request_size gets an error response and is skipped.
+//
+// Requests are rendered by a pool of worker threads. Response buffers are recycled once written,
+// so a warm server doesn't grow a new buffer for every response; parsing and rendering a request
+// still allocate. At most two requests per worker are read ahead of the last written response,
+// which bounds the memory held by requests and finished responses that wait for a slow one.
+class render_server final
+{
+public:
+    static constexpr size_t max_request_size = 1 << 20;
+
+    render_server(std::istream& input, std::ostream& output, unsigned thread_count = std::thread::hardware_concurrency())
+        : m_input{input}
+        , m_output{output}
+        , m_thread_count{std::max(thread_count, 1u)}
+    {}
+
+    void run()
+    {
+        // Requests are read on this thread while workers write responses under the output lock. A
+        // stream tied to the input, like std::cout to std::cin, would be flushed here without it.
+        m_input.tie(nullptr);
+
+        std::vector<std::thread> workers;
+
+        for (unsigned i = 0; i < m_thread_count; ++i)
+            workers.emplace_back([this] { work(); });
+
+        read_requests();
+
+        {
+            std::lock_guard lock{m_jobs_mutex};
+            m_done = true;
+        }
+
+        m_jobs_changed.notify_all();
+
+        for (auto& worker : workers)
+            worker.join();
+
+        m_output.flush();
+    }
+
+private:
+    struct job final
+    {
+        size_t sequence{};
+        std::string description;
+    };
+
+    struct response final
+    {
+        bool ok{};
+        std::string body;
+    };
+
+    // Appends to a string, which keeps its capacity when the caller clears it between uses.
+    class string_streambuf final : public std::streambuf
+    {
+    public:
+        void set_target(std::string& target)
+        {
+            m_target = &target;
+        }
+
+    protected:
+        int_type overflow(int_type ch) override
+        {
+            if (!traits_type::eq_int_type(ch, traits_type::eof()))
+                m_target->push_back(traits_type::to_char_type(ch));
+
+            return traits_type::not_eof(ch);
+        }
+
+        std::streamsize xsputn(const char* data, std::streamsize count) override
+        {
+            m_target->append(data, static_cast<size_t>(count));
+            return count;
+        }
+
+    private:
+        std::string* m_target{};
+    };
+
+    void read_requests()
+    {
+        std::string header;
+
+        for (size_t sequence = 0; ; ++sequence)
+        {
+            {
+                // Back-pressure: don't read further ahead than the writes of responses keep up with.
+                std::unique_lock lock{m_jobs_mutex};
+                m_jobs_changed.wait(lock, [&] { return sequence - m_written < m_thread_count * 2; });
+            }
+
+            if (!std::getline(m_input, header))
+                return;
+
+            if (header.empty() || header.size() > 9 || header.find_first_not_of("0123456789") != std::string::npos)
+            {
+                // Without a valid byte count there's no telling where the next request starts.
+                complete(sequence, {false, "invalid request header '" + header + "'"});
+                return;
+            }
+
+            const size_t size = std::stoul(header);
+
+            if (size > max_request_size)
+            {
+                if (!m_input.ignore(static_cast<std::streamsize>(size)) || static_cast<size_t>(m_input.gcount()) != size)
+                {
+                    complete(sequence, {false, "truncated request"});
+                    return;
+                }
+
+                complete(sequence, {false, "request of " + header + " bytes exceeds the maximum of " + std::to_string(max_request_size)});
+                continue;
+            }
+
+            job request{sequence, std::string(size, '\0')};
+
+            if (!m_input.read(request.description.data(), static_cast<std::streamsize>(request.description.size())))
+            {
+                complete(sequence, {false, "truncated request"});
+                return;
+            }
+
+            {
+                std::lock_guard lock{m_jobs_mutex};
+                m_jobs.push_back(std::move(request));
+            }
+
+            m_jobs_changed.notify_all();
+        }
+    }
+
+    void work()
+    {
+        string_streambuf buffer;
+        std::ostream stream{&buffer};
+        std::string error;
+
+        for (;;)
+        {
+            std::unique_lock lock{m_jobs_mutex};
+            m_jobs_changed.wait(lock, [&] { return !m_jobs.empty() || m_done; });
+
+            if (m_jobs.empty())
+                return;
+
+            job request = std::move(m_jobs.front());
+            m_jobs.pop_front();
+            lock.unlock();
+
+            response result{true, take_buffer()};
+
+            if (const auto diagram = read_diagram(request.description, error))
+            {
+                buffer.set_target(result.body);
+                diagram->write_svg(stream);
+            }
+            else
+            {
+                result.ok = false;
+                result.body.assign(error);
+            }
+
+            complete(request.sequence, std::move(result));
+        }
+    }
+
+    std::string take_buffer()
+    {
+        std::lock_guard lock{m_output_mutex};
+
+        if (m_buffers.empty())
+            return {};
+
+        std::string buffer = std::move(m_buffers.back());
+        m_buffers.pop_back();
+        return buffer;
+    }
+
+    // Writes all responses that are next in line, recycles their buffers, and lets the reader know
+    // there's room for more requests.
+    void complete(size_t sequence, response&& result)
+    {
+        std::lock_guard lock{m_output_mutex};
+        m_responses.insert({sequence, std::move(result)});
+
+        const size_t first = m_next_sequence;
+
+        for (auto next = m_responses.find(m_next_sequence); next != m_responses.end(); next = m_responses.find(++m_next_sequence))
+        {
+            auto& [ok, body] = next->second;
+            m_output << (ok ? "ok " : "error ") << body.size() << '\n';
+            m_output.write(body.data(), static_cast<std::streamsize>(body.size()));
+            m_output.flush();
+
+            body.clear();
+            m_buffers.push_back(std::move(body));
+            m_responses.erase(next);
+        }
+
+        if (m_next_sequence == first)
+            return;
+
+        {
+            std::lock_guard jobs_lock{m_jobs_mutex};
+            m_written = m_next_sequence;
+        }
+
+        m_jobs_changed.notify_all();
+    }
+
+    std::istream& m_input;
+    std::ostream& m_output;
+    unsigned m_thread_count{};
+
+    std::mutex m_jobs_mutex;
+    std::condition_variable m_jobs_changed;
+    std::deque<job> m_jobs;
+    size_t m_written{};
+    bool m_done{};
+
+    std::mutex m_output_mutex;
+    std::map<size_t, response> m_responses;
+    size_t m_next_sequence{};
+    std::vector<std::string> m_buffers;
+};
+
+} // namespace jg
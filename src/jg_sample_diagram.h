@@ -0,0 +1,32 @@
+#pragma once
+
+#include <array>
+#include "jg_diagram.h"
+
+namespace jg
+{
+
+// The diagram jg_diag renders by default, which jg_diag.svg shows.
+diagram sample_diagram()
+{
+    jg::diagram diagram{"jg-diagram-sample"};
+
+    const std::array item_ids
+    {
+        diagram.add_item(jg::rectangle    {{ 50, 100, 300, 100}, "Rectangle"}),
+        diagram.add_item(jg::ellipse      {{500,  50, 300, 100}, "Ellipse"}),
+        diagram.add_item(jg::rhombus      {{550, 500, 300, 100}, "Rhombus"}),
+        diagram.add_item(jg::parallelogram{{ 50, 500, 400, 100}, "Parallelogram"}),
+        diagram.add_item(jg::circle       {{200, 250, 150, 150}, "Circle"})
+    };
+
+    diagram.add_item(jg::line{item_ids[0], item_ids[1], jg::line_kind::filled_arrow});
+    diagram.add_item(jg::line{item_ids[1], item_ids[2], jg::line_kind::filled_arrow});
+    diagram.add_item(jg::line{item_ids[2], item_ids[3], jg::line_kind::filled_arrow});
+    diagram.add_item(jg::line{item_ids[3], item_ids[4], jg::line_kind::filled_arrow});
+    diagram.add_item(jg::line{item_ids[4], item_ids[0], jg::line_kind::filled_arrow});
+
+    return diagram;
+}
+
+} // namespace jg
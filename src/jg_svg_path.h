@@ -0,0 +1,249 @@
+#pragma once
+
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include "jg_coordinates.h"
+
+namespace jg
+{
+
+// Formats numbers the way minified SVG does: quantized to a fixed number of decimals and written
+// in their shortest exact form, without trailing zeros or a leading zero ("0.50" -> ".5").
+// Values that are too large to quantize, and infinities and NaNs, are written the way a stream
+// writes floats instead.
+class svg_number_format final
+{
+public:
+    explicit svg_number_format(int precision = 2)
+        : m_precision{precision < 0 ? 0 : precision > 6 ? 6 : precision}
+    {
+        for (int i = 0; i < m_precision; ++i)
+            m_units_per_one *= 10;
+    }
+
+    // The value in units of the precision, e.g. 1.234f -> 123 with two decimals. Values out of
+    // range are clamped to +-max_units, and NaN is 0, so sums and differences of units never overflow.
+    std::int64_t quantize(float value) const
+    {
+        const double units = static_cast<double>(value) * static_cast<double>(m_units_per_one);
+
+        if (std::isnan(units))
+            return 0;
+
+        if (std::abs(units) >= static_cast<double>(max_units))
+            return units < 0 ? -max_units : max_units;
+
+        return std::llround(units);
+    }
+
+    void append(std::string& result, float value) const
+    {
+        if (!quantizable(value))
+        {
+            std::ostringstream stream;
+            stream << value;
+            result += stream.str();
+            return;
+        }
+
+        append_units(result, quantize(value));
+    }
+
+    void append_units(std::string& result, std::int64_t units) const
+    {
+        // Negated as unsigned, which is defined for every value, INT64_MIN included.
+        auto magnitude = static_cast<std::uint64_t>(units);
+
+        if (units < 0)
+        {
+            result += '-';
+            magnitude = 0 - magnitude;
+        }
+
+        const auto units_per_one = static_cast<std::uint64_t>(m_units_per_one);
+        const std::uint64_t whole = magnitude / units_per_one;
+        std::uint64_t fraction = magnitude % units_per_one;
+
+        if (whole != 0 || fraction == 0)
+            result += std::to_string(whole);
+
+        if (fraction == 0)
+            return;
+
+        int digits = m_precision;
+
+        while (fraction % 10 == 0)
+        {
+            fraction /= 10;
+            --digits;
+        }
+
+        const auto fraction_digits = std::to_string(fraction);
+        result += '.';
+        result.append(static_cast<size_t>(digits) - fraction_digits.size(), '0');
+        result += fraction_digits;
+    }
+
+    std::string to_string(float value) const
+    {
+        std::string result;
+        append(result, value);
+        return result;
+    }
+
+    // 2^53: every quantized value is exact as a double, too.
+    static constexpr std::int64_t max_units = std::int64_t{1} << 53;
+
+private:
+    // False for infinities and NaN as well.
+    bool quantizable(float value) const
+    {
+        return std::abs(static_cast<double>(value) * static_cast<double>(m_units_per_one)) < static_cast<double>(max_units);
+    }
+
+    int m_precision{};
+    std::int64_t m_units_per_one{1};
+};
+
+// Builds path data (and point lists) in the most compact form: the first point is absolute, the
+// rest are relative to the previous one, using h/v for axis aligned segments, with repeated
+// commands and redundant separators left out.
+class svg_path final
+{
+public:
+    explicit svg_path(const svg_number_format& format)
+        : m_format{format}
+    {}
+
+    // Starts over, keeping the allocated buffer.
+    void clear()
+    {
+        m_data.clear();
+        m_command = 0;
+        m_x = 0;
+        m_y = 0;
+        m_start_x = 0;
+        m_start_y = 0;
+        m_last_has_dot = false;
+    }
+
+    svg_path& move_to(jg::point point)
+    {
+        const auto x = m_format.quantize(point.x);
+        const auto y = m_format.quantize(point.y);
+
+        if (m_data.empty())
+            command('M');
+        else
+            command('m');
+
+        const bool absolute = m_command == 'M';
+        number(absolute ? x : x - m_x);
+        number(absolute ? y : y - m_y);
+
+        m_x = m_start_x = x;
+        m_y = m_start_y = y;
+
+        // Coordinates following a moveto are implicit linetos, absolute after M and relative after m.
+        m_command = absolute ? 'L' : 'l';
+
+        return *this;
+    }
+
+    svg_path& line_to(jg::point point)
+    {
+        const auto x = m_format.quantize(point.x);
+        const auto y = m_format.quantize(point.y);
+
+        if (y == m_y)
+        {
+            command('h');
+            number(x - m_x);
+        }
+        else if (x == m_x)
+        {
+            command('v');
+            number(y - m_y);
+        }
+        else
+        {
+            command('l');
+            number(x - m_x);
+            number(y - m_y);
+        }
+
+        m_x = x;
+        m_y = y;
+
+        return *this;
+    }
+
+    svg_path& close()
+    {
+        m_data += 'z';
+        m_command = 0;
+        m_x = m_start_x;
+        m_y = m_start_y;
+        m_last_has_dot = false;
+
+        return *this;
+    }
+
+    // A plain list of absolute coordinates, like the points attribute of <polygon>.
+    svg_path& point(jg::point point)
+    {
+        number(m_format.quantize(point.x));
+        number(m_format.quantize(point.y));
+
+        return *this;
+    }
+
+    std::string_view str() const
+    {
+        return m_data;
+    }
+
+private:
+    void command(char letter)
+    {
+        if (letter == m_command)
+            return;
+
+        m_data += letter;
+        m_command = letter;
+        m_last_has_dot = false;
+    }
+
+    // A separator is only needed where the next number could be read as part of the previous one.
+    void number(std::int64_t units)
+    {
+        const size_t start = m_data.size();
+        const bool needs_separator = start > 0 && (std::isdigit(static_cast<unsigned char>(m_data.back())) || m_data.back() == '.');
+
+        m_format.append_units(m_data, units);
+
+        const std::string_view text{m_data.data() + start, m_data.size() - start};
+        const bool has_dot = text.find('.') != std::string_view::npos;
+        const bool self_delimiting = text[0] == '-' || (text[0] == '.' && m_last_has_dot);
+
+        if (needs_separator && !self_delimiting)
+            m_data.insert(start, 1, ' ');
+
+        m_last_has_dot = has_dot;
+    }
+
+    const svg_number_format& m_format;
+    std::string m_data;
+    char m_command{};
+    std::int64_t m_x{};
+    std::int64_t m_y{};
+    std::int64_t m_start_x{};
+    std::int64_t m_start_y{};
+    bool m_last_has_dot{};
+};
+
+} // namespace jg
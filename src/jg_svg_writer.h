@@ -1,11 +1,13 @@
 #pragma once
 
-#include <sstream>
+#include <optional>
+#include <string>
 #include <type_traits>
 #include <cmath>
 #include <jg_verify.h>
 #include "jg_xml_writer.h"
 #include "jg_coordinates.h"
+#include "jg_svg_path.h"
 
 namespace jg
 {
@@ -82,40 +84,50 @@ struct svg_text_attributes final
 class svg_writer final
 {
 public:
-    svg_writer(std::ostream& stream, jg::size size)
+    // The scale maps user units to output pixels; the content itself is always written in user units.
+    // Coordinates are rounded to the given number of decimals.
+    svg_writer(std::ostream& stream, jg::size size, float scale = 1, int precision = 2)
         : m_stream{stream}
         , m_size{size}
         , m_root{xml_writer::root_element(m_stream, "svg")}
+        , m_format{precision}
     {
-        m_root.write_attribute("width", m_size.width);
-        m_root.write_attribute("height", m_size.height);
+        m_root.write_attribute("width", number(m_size.width * scale));
+        m_root.write_attribute("height", number(m_size.height * scale));
+
+        if (scale != 1)
+        {
+            m_path.clear();
+            m_path.point({0, 0}).point({m_size.width, m_size.height});
+            m_root.write_attribute("viewBox", m_path.str());
+        }
+
         m_root.write_attribute("version", "1.1");
         m_root.write_attribute("baseProfile", "full");
         m_root.write_attribute("xmlns", "http://www.w3.org/2000/svg");
+        m_root.write_attribute("xmlns:xlink", "http://www.w3.org/1999/xlink");
 
         auto defs = xml_writer::child_element(m_root, "defs");
         
         auto marker = xml_writer::child_element(defs, "marker");
         marker.write_attribute("id", "arrowhead");
-        marker.write_attribute("markerWidth", m_arrowhead_length);
-        marker.write_attribute("markerHeight", m_arrowhead_length);
+        marker.write_attribute("markerWidth", number(m_arrowhead_length));
+        marker.write_attribute("markerHeight", number(m_arrowhead_length));
         marker.write_attribute("refX", "0");
-        marker.write_attribute("refY", m_arrowhead_length / 2);
+        marker.write_attribute("refY", number(m_arrowhead_length / 2));
         marker.write_attribute("orient", "auto");
         marker.write_attribute("markerUnits", "userSpaceOnUse");
 
-        std::ostringstream points;
-        points << "0 0, ";
-        points << m_arrowhead_length << " " << m_arrowhead_length / 2;
-        points << ", 0 " << m_arrowhead_length;
+        m_path.clear();
+        m_path.point({0, 0}).point({m_arrowhead_length, m_arrowhead_length / 2}).point({0, m_arrowhead_length});
 
         auto polygon = xml_writer::child_element(marker, "polygon");
-        polygon.write_attribute("points", points.str());
+        polygon.write_attribute("points", m_path.str());
     }
 
     void write_background(std::string_view color = "white")
     {
-        auto tag = xml_writer::child_element(m_root, "rect");
+        auto tag = xml_writer::child_element(parent(), "rect");
         tag.write_attribute("width", "100%");
         tag.write_attribute("height", "100%");
         tag.write_attribute("fill", color);
@@ -138,7 +150,7 @@ public:
         constexpr float font_size = 25;
         svg_text_attributes attributes;
         attributes.text_anchor = svg_text_anchor::start;
-        attributes.font = {std::to_string(font_size), "sans-serif", "bold", "normal"};
+        attributes.font = {m_format.to_string(font_size), "sans-serif", "bold", "normal"};
         attributes.text_anchor = svg_text_anchor::start;
         attributes.dominant_baseline = svg_dominant_baseline::middle;
 
@@ -147,11 +159,11 @@ public:
 
     void write_border()
     {
-        auto tag = xml_writer::child_element(m_root, "rect");
-        tag.write_attribute("x", 0);
-        tag.write_attribute("y", 0);
-        tag.write_attribute("width", m_size.width);
-        tag.write_attribute("height", m_size.height);
+        auto tag = xml_writer::child_element(parent(), "rect");
+        tag.write_attribute("x", number(0));
+        tag.write_attribute("y", number(0));
+        tag.write_attribute("width", number(m_size.width));
+        tag.write_attribute("height", number(m_size.height));
         tag.write_attribute("fill", "transparent");
         tag.write_attribute("stroke", "black");
         tag.write_attribute("stroke-width", 1);
@@ -159,29 +171,34 @@ public:
 
     void write_line(jg::point point1, jg::point point2, const svg_paint_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "line");
-        tag.write_attribute("x1", point1.x);
-        tag.write_attribute("y1", point1.y);
-        tag.write_attribute("x2", point2.x);
-        tag.write_attribute("y2", point2.y);
+        auto tag = xml_writer::child_element(parent(), "line");
+        tag.write_attribute("x1", number(point1.x));
+        tag.write_attribute("y1", number(point1.y));
+        tag.write_attribute("x2", number(point2.x));
+        tag.write_attribute("y2", number(point2.y));
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
     }
 
+    // An arrow without length has no direction to point in, and isn't written.
     void write_arrow(jg::point point1, jg::point point2, const svg_paint_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "line");
-        tag.write_attribute("x1", point1.x);
-        tag.write_attribute("y1", point1.y);
-
         const float dx = point2.x - point1.x;
         const float dy = point2.y - point1.y;
         const float distance = std::hypotf(dx, dy);
+
+        if (!(distance > 0))
+            return;
+
+        auto tag = xml_writer::child_element(parent(), "line");
+        tag.write_attribute("x1", number(point1.x));
+        tag.write_attribute("y1", number(point1.y));
+
         const float ddx = m_arrowhead_length * dx / distance;
         const float ddy = m_arrowhead_length * dy / distance;
 
-        tag.write_attribute("x2", point2.x - ddx);
-        tag.write_attribute("y2", point2.y - ddy);
+        tag.write_attribute("x2", number(point2.x - ddx));
+        tag.write_attribute("y2", number(point2.y - ddy));
 
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -190,11 +207,11 @@ public:
 
     void write_rect(jg::rect rect, const svg_paint_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "rect");
-        tag.write_attribute("x", rect.x);
-        tag.write_attribute("y", rect.y);
-        tag.write_attribute("width", rect.width);
-        tag.write_attribute("height", rect.height);
+        auto tag = xml_writer::child_element(parent(), "rect");
+        tag.write_attribute("x", number(rect.x));
+        tag.write_attribute("y", number(rect.y));
+        tag.write_attribute("width", number(rect.width));
+        tag.write_attribute("height", number(rect.height));
         tag.write_attribute("fill", attributes.fill);
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -207,15 +224,11 @@ public:
         const jg::point point3{rect.x + rect.width    , rect.y + rect.height / 2};
         const jg::point point4{rect.x + rect.width / 2, rect.y + rect.height};
 
-        std::ostringstream path;
-        path << "M"  << point1.x << " " << point1.y;
-        path << " L" << point2.x << " " << point2.y;
-        path << " L" << point3.x << " " << point3.y;
-        path << " L" << point4.x << " " << point4.y;
-        path << " Z";
-        
-        auto tag = xml_writer::child_element(m_root, "path");
-        tag.write_attribute("d", path.str());
+        m_path.clear();
+        m_path.move_to(point1).line_to(point2).line_to(point3).line_to(point4).close();
+
+        auto tag = xml_writer::child_element(parent(), "path");
+        tag.write_attribute("d", m_path.str());
         tag.write_attribute("fill", attributes.fill);
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -229,15 +242,11 @@ public:
         const jg::point point3{rect.x + rect.width - rect.height, rect.y + rect.height};
         const jg::point point4{rect.x                           , rect.y + rect.height};
 
-        std::ostringstream path;
-        path << "M"  << point1.x << " " << point1.y;
-        path << " L" << point2.x << " " << point2.y;
-        path << " L" << point3.x << " " << point3.y;
-        path << " L" << point4.x << " " << point4.y;
-        path << " Z";
-        
-        auto tag = xml_writer::child_element(m_root, "path");
-        tag.write_attribute("d", path.str());
+        m_path.clear();
+        m_path.move_to(point1).line_to(point2).line_to(point3).line_to(point4).close();
+
+        auto tag = xml_writer::child_element(parent(), "path");
+        tag.write_attribute("d", m_path.str());
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("fill", attributes.fill);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -246,9 +255,9 @@ public:
 
     void write_text(jg::point point, std::string_view text, const svg_text_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "text");
-        tag.write_attribute("x", point.x);
-        tag.write_attribute("y", point.y);
+        auto tag = xml_writer::child_element(parent(), "text");
+        tag.write_attribute("x", number(point.x));
+        tag.write_attribute("y", number(point.y));
         tag.write_attribute("font-size", attributes.font.size);
         tag.write_attribute("font-family", attributes.font.family);
         tag.write_attribute("font-weight", attributes.font.weight);
@@ -262,10 +271,10 @@ public:
 
     void write_circle(jg::point point, float radius, const svg_paint_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "circle");
-        tag.write_attribute("cx", point.x);
-        tag.write_attribute("cy", point.y);
-        tag.write_attribute("r", radius);
+        auto tag = xml_writer::child_element(parent(), "circle");
+        tag.write_attribute("cx", number(point.x));
+        tag.write_attribute("cy", number(point.y));
+        tag.write_attribute("r", number(radius));
         tag.write_attribute("fill", attributes.fill);
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -273,11 +282,11 @@ public:
 
     void write_ellipse(jg::point point, float xradius, float yradius, const svg_paint_attributes& attributes)
     {
-        auto tag = xml_writer::child_element(m_root, "ellipse");
-        tag.write_attribute("cx", point.x);
-        tag.write_attribute("cy", point.y);
-        tag.write_attribute("rx", xradius);
-        tag.write_attribute("ry", yradius);
+        auto tag = xml_writer::child_element(parent(), "ellipse");
+        tag.write_attribute("cx", number(point.x));
+        tag.write_attribute("cy", number(point.y));
+        tag.write_attribute("rx", number(xradius));
+        tag.write_attribute("ry", number(yradius));
         tag.write_attribute("fill", attributes.fill);
         tag.write_attribute("stroke", attributes.stroke);
         tag.write_attribute("stroke-width", attributes.stroke_width);
@@ -285,14 +294,69 @@ public:
 
     void write_comment(std::string_view comment)
     {
-        auto tag = xml_writer::child_element(m_root, "");
+        auto tag = xml_writer::child_element(parent(), "");
         tag.write_comment(comment);
     }
 
+    // How numbers in attributes are written, for attribute values built outside the writer.
+    const svg_number_format& number_format() const
+    {
+        return m_format;
+    }
+
+    // Elements written between begin_symbol() and end_symbol() go into a reusable <symbol> in
+    // <defs>, which write_use() then places by its top-left corner.
+    void begin_symbol(std::string_view id)
+    {
+        m_symbol.reset();
+
+        if (!m_defs)
+            m_defs.emplace(xml_writer::child_element(m_root, "defs"));
+
+        m_symbol.emplace(xml_writer::child_element(*m_defs, "symbol"));
+        m_symbol->write_attribute("id", id);
+        m_symbol->write_attribute("overflow", "visible");
+    }
+
+    void end_symbol()
+    {
+        m_symbol.reset();
+    }
+
+    void write_use(std::string_view id, jg::point point)
+    {
+        auto tag = xml_writer::child_element(parent(), "use");
+        tag.write_attribute("xlink:href", std::string{"#"}.append(id));
+        tag.write_attribute("x", number(point.x));
+        tag.write_attribute("y", number(point.y));
+    }
+
 private:
+    // The view is only valid until the next call.
+    std::string_view number(float value)
+    {
+        m_number.clear();
+        m_format.append(m_number, value);
+        return m_number;
+    }
+
+    xml_writer& parent()
+    {
+        if (m_symbol)
+            return *m_symbol;
+
+        m_defs.reset();
+        return m_root;
+    }
+
     std::ostream& m_stream;
     jg::size m_size;
     xml_writer m_root;
+    std::optional<xml_writer> m_defs;
+    std::optional<xml_writer> m_symbol;
+    svg_number_format m_format;
+    svg_path m_path{m_format};
+    std::string m_number;
     float m_arrowhead_length{20.0f};
 };
 
@@ -2,6 +2,8 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
 namespace jg
 {
@@ -52,16 +54,29 @@ public:
         *m_stream << "\n";
     }
 
+    // Text values are escaped, numbers are written as they are.
     template <typename T>
     void write_attribute(std::string_view name, const T& value)
     {
-        *m_stream << ' ' << name << "=\"" << value << "\"";
+        *m_stream << ' ' << name << "=\"";
+
+        if constexpr (std::is_convertible_v<const T&, std::string_view>)
+            write_escaped(value);
+        else
+            *m_stream << value;
+
+        *m_stream << "\"";
     }
 
+    // A comment can't contain "--", so every run of dashes is written as a single one.
     void write_comment(std::string_view comment)
     {
         m_is_comment = true;
-        *m_stream << "!--" << comment;
+        *m_stream << "!--";
+
+        for (size_t i = 0; i < comment.size(); ++i)
+            if (comment[i] != '-' || i == 0 || comment[i - 1] != '-')
+                *m_stream << comment[i];
     }
 
     void write_text(std::string_view text)
@@ -72,7 +87,7 @@ public:
             *m_stream << (m_is_comment ? "-->" : ">");
         }
 
-        *m_stream << text;
+        write_escaped(text);
     }
 
 private:
@@ -96,6 +111,32 @@ private:
         *m_stream << "<" << m_name;
     }
 
+    // Writes unescaped stretches in one go, since most text needs no escaping at all.
+    void write_escaped(std::string_view text)
+    {
+        size_t start = 0;
+
+        for (size_t i = 0; i < text.size(); ++i)
+        {
+            const char* entity = nullptr;
+
+            switch (text[i])
+            {
+                case '&': entity = "&amp;";  break;
+                case '<': entity = "&lt;";   break;
+                case '>': entity = "&gt;";   break;
+                case '"': entity = "&quot;"; break;
+                default: continue;
+            }
+
+            m_stream->write(text.data() + start, static_cast<std::streamsize>(i - start));
+            *m_stream << entity;
+            start = i + 1;
+        }
+
+        m_stream->write(text.data() + start, static_cast<std::streamsize>(text.size() - start));
+    }
+
     std::ostream* m_stream{};
     std::string m_name;
     bool m_is_parent{};
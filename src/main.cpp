@@ -1,313 +1,21 @@
-#include <array>
-#include <map>
-#include <unordered_map>
-#include <variant>
-#include <vector>
-#include "jg_svg_writer.h"
-
-namespace jg
-{
-
-using anchor_array = std::array<jg::point, 4>;
-
-template <typename TAnchorPolicy>
-class shape final
-{
-public:
-    shape(jg::rect bounds, std::string_view text)
-        : m_bounds{bounds}
-        , m_text{text}
-    {}
-
-    jg::rect bounds() const
-    {
-        return m_bounds;
-    }
-
-    std::string_view text() const
-    {
-        return m_text;
-    }
-
-    anchor_array anchors() const
-    {
-        return TAnchorPolicy::anchors(m_bounds);
-    }
-
-private:
-    jg::rect m_bounds;
-    std::string m_text;
-};
-
-//     x
-//  x     x
-//     x
-struct rectangle_anchors final
-{
-    static anchor_array anchors(const jg::rect& bounds)
-    {
-        return
-        {
-            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width / 2, bounds.y},
-            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
-        };
-    }
-};
-
-using rectangle = shape<rectangle_anchors>;
-
-//     x
-//  x     x
-//     x
-struct rhombus_anchors final
-{
-    static anchor_array anchors(const jg::rect& bounds)
-    {
-        return
-        {
-            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width / 2, bounds.y},
-            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
-        };
-    }
-};
-
-using rhombus = shape<rhombus_anchors>;
-
-//       x
-//  x      x
-//    x
-struct parallelogram_anchors final
-{
-    static anchor_array anchors(const jg::rect& bounds)
-    {
-        return
-        {
-            jg::point{bounds.x + bounds.height / 2,                bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width / 2,                 bounds.y},
-            jg::point{bounds.x + bounds.width - bounds.height / 2, bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width / 2,                 bounds.y + bounds.height}
-        };
-    }
-};
-
-using parallelogram = shape<parallelogram_anchors>;
-
-//      x
-//  x       x
-//      x
-struct ellipse_anchors final
-{
-    static anchor_array anchors(const jg::rect& bounds)
-    {
-        return
-        {
-            jg::point{bounds.x                   , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width    , bounds.y + bounds.height / 2},
-            jg::point{bounds.x + bounds.width / 2, bounds.y},
-            jg::point{bounds.x + bounds.width / 2, bounds.y + bounds.height}
-        };
-    }
-};
-
-using ellipse = shape<ellipse_anchors>;
-
-//     x
-//  x     x
-//     x
-struct circle_anchors final
-{
-    static anchor_array anchors(const jg::rect& bounds)
-    {
-        const auto diameter = std::min(bounds.width, bounds.height);
-
-        return
-        {
-            jg::point{bounds.x               , bounds.y + diameter / 2},
-            jg::point{bounds.x + diameter    , bounds.y + diameter / 2},
-            jg::point{bounds.x + diameter / 2, bounds.y},
-            jg::point{bounds.x + diameter / 2, bounds.y + diameter}
-        };
-    }
-};
-
-using circle = shape<circle_anchors>;
-
-using item_id = size_t;
-
-enum class line_kind
-{
-    filled_arrow
-};
-
-class line final
-{
-public:
-    item_id source_id{};
-    item_id target_id{};
-    line_kind kind{};
-};
-
-// https://www.bfilipek.com/2018/06/variant.html#overload
-template<class... Ts> struct overload : Ts... { using Ts::operator()...; };
-template<class... Ts> overload(Ts...) -> overload<Ts...>;
-
-class diagram final
-{
-public:
-    diagram(std::string_view title = "")
-        : m_title{title}
-    {}
-
-    template <typename T>
-    item_id add_item(T&& item)
-    {
-        const auto id = new_id();
-        
-        std::visit([&](const auto& shape)
-        {
-            const auto& bounds = shape.bounds();
-
-            if (bounds.x + bounds.width > m_size.width - 50)
-                m_size.width = bounds.x + bounds.width + 50;
-
-            if (bounds.y + bounds.height > m_size.height - 50)
-                m_size.height = bounds.y + bounds.height + 50;
-
-        }, m_items.insert({id, std::move(item)}).first->second);
-
-        return id;
-    }
-
-    void add_item(line&& item)
-    {
-        m_lines.push_back(std::move(item));
-    }
-
-    void write_svg(std::ostream& stream) const
-    {
-        jg::svg_writer svg{stream, m_size};
-        svg.write_background();
-
-        svg.write_comment("Grid");
-        svg.write_grid(50);
-
-        const jg::svg_paint_attributes default_paint{"#d7eff6", "black", "3"};
-
-        constexpr float font_size = 25;
-        jg::svg_text_attributes default_text;
-        default_text.font.size = std::to_string(font_size);
-        default_text.font.family = "sans-serif";
-        default_text.font.weight = "bold";
-        default_text.text_anchor = svg_text_anchor::middle;
-        default_text.dominant_baseline = svg_dominant_baseline::middle;
-
-        for (const auto& [_, item] : m_items)
-        {
-            const jg::rect bounds = std::visit([&](const auto& shape)
-            {
-                return shape.bounds();
-            }, item);
-
-            std::visit(jg::overload
-            {
-                [&](const jg::rectangle&)
-                {
-                    svg.write_rect({bounds.x, bounds.y, bounds.width, bounds.height}, default_paint);
-                },
-                [&](const jg::rhombus&)
-                {
-                    svg.write_rhombus({bounds.x, bounds.y, bounds.width, bounds.height}, default_paint);
-                },
-                [&](const jg::parallelogram&)
-                {
-                    svg.write_parallelogram({bounds.x, bounds.y, bounds.width, bounds.height}, default_paint);
-                },
-                [&](const jg::ellipse&)
-                {
-                    svg.write_ellipse({bounds.x + bounds.width / 2, bounds.y + bounds.height / 2}, bounds.width / 2, bounds.height / 2, default_paint);
-                },
-                [&](const jg::circle&)
-                {
-                    const auto radius = std::min(bounds.width, bounds.height) / 2;
-                    svg.write_circle({bounds.x + radius, bounds.y + radius}, radius, default_paint);
-                }
-            }, item);
-
-            std::visit([&](const auto& shape)
-            {
-                svg.write_comment(shape.text());
-                svg.write_text({bounds.x + bounds.width / 2, bounds.y + bounds.height / 2}, shape.text(), default_text);
-                
-                for (const auto& anchor : shape.anchors())
-                    svg.write_circle({anchor.x, anchor.y}, 5, {"red", "none", "1"});
-            }, item);
-        };
-
-        const jg::svg_paint_attributes default_line{"none", "black", "3"};
-
-        svg.write_comment("Arrows");
-
-        for (const auto& line : m_lines)
-        {
-            const auto source_anchors = std::visit([&] (const auto& source)
-            {
-                return source.anchors();
-            }, m_items.find(line.source_id)->second);
-
-            const auto target_anchors = std::visit([&] (const auto& target)
-            {
-                return target.anchors();
-            }, m_items.find(line.target_id)->second);
-
-            std::pair<jg::point, jg::point> anchors;
-            float shortest_distance = std::numeric_limits<float>::max();
-
-            for (const auto& source_anchor : source_anchors)
-            {
-                for (const auto& target_anchor : target_anchors)
-                {
-                    const float dx = target_anchor.x - source_anchor.x;
-                    const float dy = target_anchor.y - source_anchor.y;
-                    const float distance = std::hypotf(dx, dy);
-
-                    if (distance < shortest_distance)
-                    {
-                        shortest_distance = distance;
-                        anchors = {source_anchor, target_anchor};
-                    }
-                }
-            }
-
-            jg::debug_verify(shortest_distance != std::numeric_limits<float>::max());
-
-            svg.write_arrow({anchors.first.x, anchors.first.y},
-                            {anchors.second.x, anchors.second.y},
-                            default_line);
-        }
-
-        svg.write_title(m_title);
-        svg.write_border();
-    }
-
-private:
-    static item_id new_id()
-    {
-        static item_id id;
-        return ++id;
-    }
-
-    std::string m_title;
-    jg::size m_size;
-    using shapes = std::variant<rectangle, rhombus, parallelogram, ellipse, circle>;
-    std::map<item_id, shapes> m_items;
-    std::vector<line> m_lines;
-};
-
-} // namespace jg
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include "jg_async_output.h"
+#include "jg_diagram.h"
+#include "jg_render_server.h"
+#include "jg_sample_diagram.h"
+
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#endif
 
 /*
     const char* json = R"json(
@@ -362,24 +70,107 @@ private:
     std::cout << json;
 */
 
-int main()
+namespace
+{
+
+// Number arguments are parsed in full and without exceptions, so a typo ends in a message.
+bool parse_argument(const char* text, float& value)
+{
+    char* end = nullptr;
+    value = std::strtof(text, &end);
+    return end != text && *end == '\0';
+}
+
+bool parse_argument(const char* text, unsigned& value)
 {
-    jg::diagram diagram{"jg-diagram-sample"};
+    const char* last = text + std::strlen(text);
+    const auto [end, error] = std::from_chars(text, last, value);
+    return error == std::errc{} && end == last;
+}
+
+int usage_error(std::string_view message)
+{
+    std::cerr << "jg_diag: " << message << "\n"
+              << "usage: jg_diag [--png | --scale <factor> | --precision <decimals> | --async-output | --serve]... [--threads <count>]\n";
+    return 2;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+#ifdef _WIN32
+    // The CRT's text mode would turn every \n in a PNG into \r\n.
+    _setmode(1, _O_BINARY);
+#endif
+
+    // The render server reads all requests through std::cin; nothing here uses C stdio.
+    std::ios::sync_with_stdio(false);
+
+    bool png = false;
+    bool serve = false;
+    bool async_output = false;
+    float scale = 1;
+    unsigned precision = 2;
+    unsigned threads = std::thread::hardware_concurrency();
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string_view arg{argv[i]};
+
+        if (arg == "--png")
+            png = true;
+        else if (arg == "--serve")
+            serve = true;
+        else if (arg == "--async-output")
+            async_output = true;
+        else if (arg == "--scale" && i + 1 < argc)
+        {
+            if (!parse_argument(argv[++i], scale) || !(scale > 0) || !std::isfinite(scale))
+                return usage_error("--scale expects a positive number");
+        }
+        else if (arg == "--precision" && i + 1 < argc)
+        {
+            if (!parse_argument(argv[++i], precision) || precision > 6)
+                return usage_error("--precision expects 0 to 6 decimals");
+        }
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            if (!parse_argument(argv[++i], threads))
+                return usage_error("--threads expects a count");
+        }
+        else
+        {
+            return usage_error("unexpected argument " + std::string{arg});
+        }
+    }
+
+    if (serve)
+    {
+        jg::render_server server{std::cin, std::cout, threads};
+        server.run();
+        return 0;
+    }
 
-    const std::array item_ids
+    const auto diagram = jg::sample_diagram();
+
+    const auto write = [&](std::ostream& output)
     {
-        diagram.add_item(jg::rectangle    {{ 50, 100, 300, 100}, "Rectangle"}),
-        diagram.add_item(jg::ellipse      {{500,  50, 300, 100}, "Ellipse"}),
-        diagram.add_item(jg::rhombus      {{550, 500, 300, 100}, "Rhombus"}),
-        diagram.add_item(jg::parallelogram{{ 50, 500, 400, 100}, "Parallelogram"}),
-        diagram.add_item(jg::circle       {{200, 250, 150, 150}, "Circle"})
+        if (png)
+            diagram.write_png(output, threads, scale);
+        else
+            diagram.write_svg(output, scale, static_cast<int>(precision));
+
+        output.flush();
+        return output ? 0 : 1;
     };
 
-    diagram.add_item(jg::line{item_ids[0], item_ids[1], jg::line_kind::filled_arrow});
-    diagram.add_item(jg::line{item_ids[1], item_ids[2], jg::line_kind::filled_arrow});
-    diagram.add_item(jg::line{item_ids[2], item_ids[3], jg::line_kind::filled_arrow});
-    diagram.add_item(jg::line{item_ids[3], item_ids[4], jg::line_kind::filled_arrow});
-    diagram.add_item(jg::line{item_ids[4], item_ids[0], jg::line_kind::filled_arrow});
-    
-    diagram.write_svg(std::cout);
+    // Writing on a separate thread only pays off for large exports to slow destinations, with a
+    // core to spare (see jg_async_output_bench).
+    if (!async_output)
+        return write(std::cout);
+
+    // File descriptor 1 is stdout, also with the Windows CRT.
+    jg::async_fd_ostream output{1};
+    return write(output);
 }
@@ -0,0 +1,149 @@
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "jg_async_output.h"
+#include "jg_test.h"
+
+namespace
+{
+
+// Writes of all sizes, from single characters to several buffers' worth, with every byte value.
+template <typename TStream>
+void write_sample(TStream& stream)
+{
+    for (int i = 0; i < 1000; ++i)
+    {
+        stream << i << ' ';
+        stream.put(static_cast<char>(i % 256));
+        stream << std::string(static_cast<size_t>(i % 37), static_cast<char>('a' + i % 26));
+
+        if (i % 100 == 0)
+            stream.flush();
+    }
+}
+
+std::string read_all(int fd)
+{
+    std::string result;
+    char chunk[4096];
+    ssize_t size;
+
+    while ((size = ::read(fd, chunk, sizeof(chunk))) > 0)
+        result.append(chunk, static_cast<size_t>(size));
+
+    return result;
+}
+
+// Buffers of a few bytes, and only two of them, make the serializing thread hand over and wait
+// for the I/O thread all the time.
+void test_round_trip_through_a_pipe()
+{
+    std::ostringstream expected;
+    write_sample(expected);
+
+    for (size_t buffer_size : {1u, 3u, 64u})
+    {
+        int fds[2];
+        JG_CHECK(::pipe(fds) == 0);
+
+        std::string received;
+        std::thread reader{[&] { received = read_all(fds[0]); }};
+
+        {
+            jg::async_fd_ostream stream{fds[1], buffer_size, 2};
+            write_sample(stream);
+            JG_CHECK(stream.good());
+        }
+
+        ::close(fds[1]);
+        reader.join();
+        ::close(fds[0]);
+
+        JG_CHECK(received == expected.str());
+    }
+}
+
+// Once a flush returns, everything before it is in the file.
+void test_flush_waits_for_the_write()
+{
+    char path[] = "/tmp/jg_async_output_test.XXXXXX";
+    const int fd = ::mkstemp(path);
+    JG_CHECK(fd >= 0);
+
+    if (fd < 0)
+        return;
+
+    {
+        jg::async_fd_ostream stream{fd, 16, 2};
+        size_t written = 0;
+
+        for (int i = 1; i <= 50; ++i)
+        {
+            const std::string chunk(static_cast<size_t>(i * 997), 'x');
+            stream << chunk;
+            written += chunk.size();
+            stream.flush();
+
+            struct stat status{};
+            JG_CHECK(::fstat(fd, &status) == 0 && static_cast<size_t>(status.st_size) == written);
+        }
+
+        JG_CHECK(stream.good());
+    }
+
+    ::close(fd);
+    ::unlink(path);
+}
+
+// A write error shows up as a bad stream at the next flush at the latest, and the stream stays bad.
+void test_write_error_makes_the_stream_bad(int fd)
+{
+    jg::async_fd_ostream stream{fd, 8, 2};
+    stream << std::string(100, 'x');
+    stream.flush();
+    JG_CHECK(stream.bad());
+
+    stream.clear();
+    stream << std::string(100, 'x');
+    stream.flush();
+    JG_CHECK(stream.bad());
+}
+
+void test_write_errors()
+{
+    // Writing to a pipe without a reader raises SIGPIPE, which would end the test; the write fails
+    // with EPIPE instead.
+    std::signal(SIGPIPE, SIG_IGN);
+
+    int fds[2];
+    JG_CHECK(::pipe(fds) == 0);
+    ::close(fds[0]);
+    test_write_error_makes_the_stream_bad(fds[1]);
+    ::close(fds[1]);
+
+    // Where there's a /dev/full, writing to it fails with ENOSPC.
+    const int full = ::open("/dev/full", O_WRONLY);
+
+    if (full >= 0)
+    {
+        test_write_error_makes_the_stream_bad(full);
+        ::close(full);
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_round_trip_through_a_pipe();
+    test_flush_waits_for_the_write();
+    test_write_errors();
+
+    return jg::test::report("jg_async_output_test");
+}
@@ -0,0 +1,173 @@
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "jg_diagram_builder.h"
+#include "jg_test.h"
+
+namespace
+{
+
+constexpr size_t shard_count = 6;
+constexpr size_t shapes_per_shard = 40;
+
+// Runs the work for every shard, either on a thread per shard (started in either order) or one
+// shard after the other.
+void for_each_shard(bool concurrent, bool reversed, const std::function<void(size_t)>& work)
+{
+    if (!concurrent)
+    {
+        for (size_t i = 0; i < shard_count; ++i)
+            work(i);
+
+        return;
+    }
+
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < shard_count; ++i)
+        threads.emplace_back(work, reversed ? shard_count - 1 - i : i);
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+jg::diagram::shapes shape(size_t shard, size_t index)
+{
+    const jg::rect bounds{50 + static_cast<float>(index) * 150, 50 + static_cast<float>(shard) * 120, 100, 50};
+    const auto text = std::to_string(shard) + "." + std::to_string(index);
+
+    switch (index % 5)
+    {
+    case 0: return jg::rectangle{bounds, text};
+    case 1: return jg::ellipse{bounds, text};
+    case 2: return jg::rhombus{bounds, text};
+    case 3: return jg::parallelogram{bounds, text};
+    default: return jg::circle{bounds, text};
+    }
+}
+
+// Every shard adds its shapes, and then lines between its own shapes and to the shapes of the
+// next shard, which another thread created.
+std::string build_svg(bool concurrent, bool reversed)
+{
+    jg::diagram_builder builder{"sharded", shard_count};
+    std::vector<std::vector<jg::item_id>> ids(shard_count);
+
+    for_each_shard(concurrent, reversed, [&](size_t s)
+    {
+        auto& shard = builder.get_shard(s);
+
+        for (size_t i = 0; i < shapes_per_shard; ++i)
+            ids[s].push_back(shard.add_item(shape(s, i)));
+    });
+
+    for_each_shard(concurrent, reversed, [&](size_t s)
+    {
+        auto& shard = builder.get_shard(s);
+        const auto& next = ids[(s + 1) % shard_count];
+
+        for (size_t i = 0; i < shapes_per_shard; ++i)
+        {
+            if (i + 1 < shapes_per_shard)
+                shard.add_item(jg::line{ids[s][i], ids[s][i + 1], jg::line_kind::filled_arrow});
+
+            shard.add_item(jg::line{ids[s][i], next[i], jg::line_kind::filled_arrow});
+        }
+    });
+
+    std::ostringstream stream;
+    builder.build().write_svg(stream);
+    return stream.str();
+}
+
+size_t count(const std::string& text, const std::string& pattern)
+{
+    size_t result = 0;
+
+    for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++result;
+
+    return result;
+}
+
+void test_concurrent_builds_match_sequential_build()
+{
+    const auto expected = build_svg(false, false);
+
+    JG_CHECK(count(expected, "<use ") == shard_count * shapes_per_shard * 2);
+    JG_CHECK(count(expected, "url(#arrowhead)") == shard_count * (shapes_per_shard * 2 - 1));
+
+    for (int run = 0; run < 8; ++run)
+        JG_CHECK(build_svg(true, run % 2 == 1) == expected);
+}
+
+void test_build_empties_the_builder()
+{
+    jg::diagram_builder builder{"empty", 2};
+    const auto a = builder.get_shard(0).add_item(jg::rectangle{{50, 50, 100, 50}, "A"});
+    const auto b = builder.get_shard(1).add_item(jg::rectangle{{250, 50, 100, 50}, "B"});
+    builder.get_shard(1).add_item(jg::line{a, b, jg::line_kind::filled_arrow});
+    builder.build();
+
+    std::ostringstream built;
+    builder.build().write_svg(built);
+
+    std::ostringstream empty;
+    jg::diagram{"empty"}.write_svg(empty);
+
+    JG_CHECK(built.str() == empty.str());
+}
+
+// Enough items per shard to take several id blocks each, reserved by the shards in turns, and a
+// second round on the same builder. The result must match a diagram built in shard order.
+void test_ids_across_blocks()
+{
+    constexpr size_t shards = 3;
+    constexpr size_t items = 2500;
+
+    jg::diagram_builder builder{"blocks", shards};
+
+    for (int round = 0; round < 2; ++round)
+    {
+        std::vector<std::vector<jg::item_id>> ids(shards);
+
+        for (size_t i = 0; i < items; ++i)
+            for (size_t s = 0; s < shards; ++s)
+                ids[s].push_back(builder.get_shard(s).add_item(shape(s, i % 50)));
+
+        for (size_t s = 0; s < shards; ++s)
+            for (size_t i = 0; i + 1 < items; i += 7)
+                builder.get_shard(s).add_item(jg::line{ids[s][i], ids[(s + 1) % shards][i + 1], jg::line_kind::filled_arrow});
+
+        jg::diagram expected{"blocks"};
+
+        for (size_t s = 0; s < shards; ++s)
+            for (size_t i = 0; i < items; ++i)
+                expected.add_item(shape(s, i % 50));
+
+        for (size_t s = 0; s < shards; ++s)
+            for (size_t i = 0; i + 1 < items; i += 7)
+                expected.add_item(jg::line{s * items + i + 1, ((s + 1) % shards) * items + i + 2, jg::line_kind::filled_arrow});
+
+        std::ostringstream built;
+        builder.build().write_svg(built);
+
+        std::ostringstream sequential;
+        expected.write_svg(sequential);
+
+        JG_CHECK(built.str() == sequential.str());
+    }
+}
+
+} // namespace
+
+int main()
+{
+    test_concurrent_builds_match_sequential_build();
+    test_build_empties_the_builder();
+    test_ids_across_blocks();
+
+    return jg::test::report("jg_diagram_builder_test");
+}
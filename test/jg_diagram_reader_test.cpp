@@ -0,0 +1,72 @@
+#include <sstream>
+#include <string>
+#include "jg_diagram_reader.h"
+#include "jg_test.h"
+
+namespace
+{
+
+// The error message for a description that must be rejected, or "accepted".
+std::string read_error(std::string_view description)
+{
+    std::string error;
+    return jg::read_diagram(description, error) ? "accepted" : error;
+}
+
+void test_valid_description()
+{
+    std::string error;
+    const auto diagram = jg::read_diagram("title sample\n"
+                                          "# a comment\n"
+                                          "\n"
+                                          "rectangle 50 100 300 100 Rectangle\n"
+                                          "ellipse 500 50 300 100 Ellipse\n"
+                                          "arrow 0 1\n", error);
+    JG_CHECK(diagram.has_value());
+
+    if (!diagram)
+        return;
+
+    std::ostringstream stream;
+    diagram->write_svg(stream);
+    JG_CHECK(stream.str().find(">Rectangle</text>") != std::string::npos);
+    JG_CHECK(stream.str().find("url(#arrowhead)") != std::string::npos);
+}
+
+void test_unknown_kind_is_reported_before_bounds()
+{
+    JG_CHECK(read_error("square 0 0 10 10 A\n") == "line 1: unknown item 'square'");
+    JG_CHECK(read_error("square\n") == "line 1: unknown item 'square'");
+    JG_CHECK(read_error("rectangle 0 0 10\n") == "line 1: expected: rectangle <x> <y> <width> <height> <text>");
+}
+
+void test_bounds_are_checked()
+{
+    JG_CHECK(read_error("rectangle 1e30 0 100 100 A\n") == "line 1: bounds must lie within +-1000000");
+    JG_CHECK(read_error("rectangle 0 0 2e6 100 A\n") == "line 1: bounds must lie within +-1000000");
+    JG_CHECK(read_error("rectangle -1e7 0 100 100 A\n") == "line 1: bounds must lie within +-1000000");
+    JG_CHECK(read_error("rectangle 0 0 -5 10 A\n") == "line 1: width and height must not be negative");
+    JG_CHECK(read_error("circle 0 0 10 -1 A\n") == "line 1: width and height must not be negative");
+    JG_CHECK(read_error("rectangle nan 0 10 10 A\n") != "accepted");
+    JG_CHECK(read_error("rectangle 0 0 0 0 A\n") == "accepted");
+    JG_CHECK(read_error("rectangle -50 -50 100 100 A\n") == "accepted");
+}
+
+void test_arrows_are_checked()
+{
+    JG_CHECK(read_error("rectangle 0 0 100 100 A\narrow 0 0\n") == "line 2: arrow must connect two different shapes");
+    JG_CHECK(read_error("rectangle 0 0 100 100 A\narrow 0 1\n") == "line 2: arrow refers to an unknown shape");
+    JG_CHECK(read_error("rectangle 0 0 100 100 A\nrectangle 0 0 100 100 B\narrow 0 1\n") == "accepted");
+}
+
+} // namespace
+
+int main()
+{
+    test_valid_description();
+    test_unknown_kind_is_reported_before_bounds();
+    test_bounds_are_checked();
+    test_arrows_are_checked();
+
+    return jg::test::report("jg_diagram_reader_test");
+}
@@ -0,0 +1,144 @@
+#include <sstream>
+#include <string>
+#include <vector>
+#include "jg_diagram.h"
+#include "jg_sample_diagram.h"
+#include "jg_test.h"
+
+namespace
+{
+
+std::string svg(const jg::diagram& diagram, float scale)
+{
+    std::ostringstream stream;
+    diagram.write_svg(stream, scale);
+    return stream.str();
+}
+
+size_t count(const std::string& text, const std::string& pattern)
+{
+    size_t result = 0;
+
+    for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++result;
+
+    return result;
+}
+
+// Ten rows of ten 100x60 rectangles, 200 units apart horizontally and 150 vertically, each row
+// chained left to right.
+jg::diagram chained_grid()
+{
+    jg::diagram diagram{"grid"};
+    std::vector<jg::item_id> ids;
+
+    for (int y = 0; y < 10; ++y)
+    {
+        for (int x = 0; x < 10; ++x)
+        {
+            ids.push_back(diagram.add_item(jg::rectangle{{50 + static_cast<float>(x) * 200, 50 + static_cast<float>(y) * 150, 100, 60}, "item"}));
+
+            if (x > 0)
+                diagram.add_item(jg::line{ids[ids.size() - 2], ids.back(), jg::line_kind::filled_arrow});
+        }
+    }
+
+    return diagram;
+}
+
+// The sample's labels (and title) are 25 units, its anchor markers 10; they're kept down to 6 and 2
+// pixels.
+void test_labels_and_anchors()
+{
+    const auto diagram = jg::sample_diagram();
+
+    JG_CHECK(count(svg(diagram, 1), "<text") == 6);
+    JG_CHECK(count(svg(diagram, 0.25f), "<text") == 6);
+    JG_CHECK(count(svg(diagram, 0.23f), "<text") == 0);
+
+    JG_CHECK(count(svg(diagram, 1), "href=\"#anchors") == 5);
+    JG_CHECK(count(svg(diagram, 0.2f), "href=\"#anchors") == 5);
+    JG_CHECK(count(svg(diagram, 0.19f), "href=\"#anchors") == 0);
+}
+
+void test_grid_is_dropped()
+{
+    const auto diagram = jg::sample_diagram();
+
+    JG_CHECK(count(svg(diagram, 1), "Grid") == 1);
+    JG_CHECK(count(svg(diagram, 0.9f), "Grid") == 0);
+}
+
+// At scale 0.01 a cell is 400 units. The shape centers fall into five columns of four cells each,
+// which make one rect per column, and every connector runs between neighbouring cells.
+void test_shapes_are_merged()
+{
+    const auto diagram = chained_grid();
+
+    const auto full = svg(diagram, 1);
+    JG_CHECK(count(full, "<use ") == 200);
+    JG_CHECK(count(full, "url(#arrowhead)") == 90);
+
+    const auto overview = svg(diagram, 0.01f);
+    JG_CHECK(count(overview, "<use ") == 0);
+    JG_CHECK(count(overview, "<line") == 0);
+    JG_CHECK(count(overview, "stroke=\"none\" stroke-width=\"0\"") == 5);
+    JG_CHECK(count(overview, "width=\"400\" height=\"1600\"") == 5);
+}
+
+// Two clusters of merged shapes, with connectors within each and between them in both directions.
+// Without arrowheads, all the connectors between the clusters are the same line.
+void test_connectors_between_cells_are_collapsed()
+{
+    jg::diagram diagram;
+    std::vector<jg::item_id> left;
+    std::vector<jg::item_id> right;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        left.push_back(diagram.add_item(jg::rectangle{{100 + static_cast<float>(i) * 10, 100, 5, 5}, ""}));
+        right.push_back(diagram.add_item(jg::rectangle{{5000 + static_cast<float>(i) * 10, 100, 5, 5}, ""}));
+    }
+
+    for (int i = 0; i < 10; ++i)
+    {
+        diagram.add_item(jg::line{left[i], right[i], jg::line_kind::filled_arrow});
+        diagram.add_item(jg::line{right[i], left[i], jg::line_kind::filled_arrow});
+
+        if (i > 0)
+            diagram.add_item(jg::line{left[i - 1], left[i], jg::line_kind::filled_arrow});
+    }
+
+    JG_CHECK(count(svg(diagram, 1), "url(#arrowhead)") == 29);
+
+    const auto overview = svg(diagram, 0.01f);
+    JG_CHECK(count(overview, "<line") == 1);
+    JG_CHECK(count(overview, "<line x1=\"200\" y1=\"200\" x2=\"5000\" y2=\"200\"") == 1);
+}
+
+// Two visible shapes with their nearest anchors 100 units apart: a connector of 1 pixel at scale
+// 0.01, which is dropped, and of 5 pixels at 0.05.
+void test_short_connectors_are_dropped()
+{
+    jg::diagram diagram;
+    const auto a = diagram.add_item(jg::rectangle{{0, 0, 1000, 1000}, ""});
+    const auto b = diagram.add_item(jg::rectangle{{1100, 0, 1000, 1000}, ""});
+    diagram.add_item(jg::line{a, b, jg::line_kind::filled_arrow});
+
+    JG_CHECK(count(svg(diagram, 0.01f), "<use ") == 2);
+    JG_CHECK(count(svg(diagram, 0.01f), "<line") == 0);
+    JG_CHECK(count(svg(diagram, 0.05f), "<line") == 1);
+}
+
+} // namespace
+
+int main()
+{
+    test_labels_and_anchors();
+    test_grid_is_dropped();
+    test_shapes_are_merged();
+    test_connectors_between_cells_are_collapsed();
+    test_short_connectors_are_dropped();
+
+    return jg::test::report("jg_level_of_detail_test");
+}
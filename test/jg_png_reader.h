@@ -0,0 +1,201 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+#include "jg_rasterizer.h"
+
+namespace jg::test
+{
+
+// Decodes the PNG subset png_writer writes: 8 bit RGBA, filter type 0, and deflate streams with
+// stored or fixed Huffman blocks. Returns nothing for anything else or for corrupt data.
+class png_reader final
+{
+public:
+    static std::optional<framebuffer> read(std::string_view png)
+    {
+        if (png.size() < 8 || png.substr(0, 8) != std::string_view{"\x89PNG\r\n\x1a\n", 8})
+            return std::nullopt;
+
+        std::uint32_t width = 0;
+        std::uint32_t height = 0;
+        std::vector<std::uint8_t> compressed;
+
+        for (size_t pos = 8; pos + 12 <= png.size();)
+        {
+            const auto size = read_u32(png, pos);
+            const auto type = png.substr(pos + 4, 4);
+
+            if (pos + 12 + size > png.size())
+                return std::nullopt;
+
+            const auto data = png.substr(pos + 8, size);
+
+            if (type == "IHDR")
+            {
+                if (size != 13 || data.substr(8, 5) != std::string_view{"\x08\x06\x00\x00\x00", 5})
+                    return std::nullopt;
+
+                width = read_u32(data, 0);
+                height = read_u32(data, 4);
+            }
+            else if (type == "IDAT")
+            {
+                compressed.insert(compressed.end(), data.begin(), data.end());
+            }
+
+            pos += 12 + size;
+        }
+
+        const auto scanlines = inflate(compressed);
+        const size_t stride = static_cast<size_t>(width) * 4 + 1;
+
+        if (!scanlines || width == 0 || height == 0 || scanlines->size() != stride * height)
+            return std::nullopt;
+
+        framebuffer image{static_cast<int>(width), static_cast<int>(height)};
+
+        for (int y = 0; y < image.height(); ++y)
+        {
+            const auto* line = scanlines->data() + static_cast<size_t>(y) * stride;
+
+            if (line[0] != 0)
+                return std::nullopt;
+
+            for (int x = 0; x < image.width(); ++x)
+            {
+                const auto* pixel = line + 1 + static_cast<size_t>(x) * 4;
+                image.row(y)[x] = {pixel[0], pixel[1], pixel[2], pixel[3]};
+            }
+        }
+
+        return image;
+    }
+
+private:
+    static std::uint32_t read_u32(std::string_view data, size_t pos)
+    {
+        return static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[pos])) << 24 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[pos + 1])) << 16 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[pos + 2])) << 8 |
+               static_cast<std::uint32_t>(static_cast<std::uint8_t>(data[pos + 3]));
+    }
+
+    static std::optional<std::vector<std::uint8_t>> inflate(const std::vector<std::uint8_t>& data)
+    {
+        if (data.size() < 6 || (data[0] & 0x0f) != 8)
+            return std::nullopt;
+
+        std::vector<std::uint8_t> result;
+        size_t bit = 16;
+        bool failed = false;
+
+        const auto bits = [&](int count)
+        {
+            std::uint32_t value = 0;
+
+            for (int i = 0; i < count; ++i, ++bit)
+            {
+                if (bit / 8 >= data.size())
+                {
+                    failed = true;
+                    return 0u;
+                }
+
+                value |= static_cast<std::uint32_t>((data[bit / 8] >> (bit % 8)) & 1) << i;
+            }
+
+            return value;
+        };
+
+        // Huffman codes are stored starting with their most significant bit.
+        const auto code = [&](int count, std::uint32_t value)
+        {
+            for (int i = 0; i < count; ++i)
+                value = (value << 1) | bits(1);
+
+            return value;
+        };
+
+        const auto symbol = [&]() -> int
+        {
+            auto value = code(7, 0);
+
+            if (value <= 0x17)
+                return static_cast<int>(256 + value);
+
+            value = code(1, value);
+
+            if (value >= 0x30 && value <= 0xbf)
+                return static_cast<int>(value - 0x30);
+
+            if (value >= 0xc0 && value <= 0xc7)
+                return static_cast<int>(280 + value - 0xc0);
+
+            return static_cast<int>(144 + code(1, value) - 0x190);
+        };
+
+        static constexpr int length_base[]{3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        static constexpr int length_extra[]{0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        static constexpr int distance_base[]{1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        static constexpr int distance_extra[]{0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+        for (bool last = false; !last && !failed;)
+        {
+            last = bits(1) != 0;
+            const auto type = bits(2);
+
+            if (type == 0)
+            {
+                bit = (bit + 7) / 8 * 8;
+                const auto length = bits(16);
+                bits(16);
+
+                for (std::uint32_t i = 0; i < length && !failed; ++i)
+                    result.push_back(static_cast<std::uint8_t>(bits(8)));
+            }
+            else if (type == 1)
+            {
+                for (int value = symbol(); value != 256 && !failed; value = symbol())
+                {
+                    if (value < 256)
+                    {
+                        result.push_back(static_cast<std::uint8_t>(value));
+                        continue;
+                    }
+
+                    if (value > 285)
+                        return std::nullopt;
+
+                    const auto l = static_cast<size_t>(value - 257);
+                    const auto length = static_cast<size_t>(length_base[l]) + bits(length_extra[l]);
+                    const auto d = code(5, 0);
+
+                    if (d >= 30)
+                        return std::nullopt;
+
+                    const auto distance = static_cast<size_t>(distance_base[d]) + bits(distance_extra[d]);
+
+                    if (distance > result.size())
+                        return std::nullopt;
+
+                    for (size_t i = 0; i < length; ++i)
+                        result.push_back(result[result.size() - distance]);
+                }
+            }
+            else
+            {
+                return std::nullopt;
+            }
+        }
+
+        if (failed)
+            return std::nullopt;
+
+        return result;
+    }
+};
+
+} // namespace jg::test
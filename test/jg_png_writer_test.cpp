@@ -0,0 +1,166 @@
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include "jg_png_reader.h"
+#include "jg_png_writer.h"
+#include "jg_sample_diagram.h"
+#include "jg_test.h"
+
+namespace
+{
+
+std::string read_file(const char* path)
+{
+    std::ifstream file{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+}
+
+void test_round_trip()
+{
+    std::ostringstream stream;
+    jg::png_writer png{stream, {30, 20}, 2};
+    png.write_background("white");
+    png.write_rect({5, 5, 10, 8}, {"#d7eff6", "black", "3"});
+    png.write_ellipse({20, 10}, 6, 4, {"red", "none", "1"});
+
+    const auto expected = png.render();
+    png.finish();
+
+    const auto decoded = jg::test::png_reader::read(stream.str());
+    JG_CHECK(decoded.has_value());
+
+    if (!decoded)
+        return;
+
+    JG_CHECK(decoded->width() == 30 && decoded->height() == 20);
+
+    bool same = true;
+
+    for (int y = 0; y < 20; ++y)
+        for (int x = 0; x < 30; ++x)
+            same = same && decoded->row(y)[x] == expected.row(y)[x];
+
+    JG_CHECK(same);
+}
+
+// "I" at font size 10 is a one pixel wide stem, three pixels of serif at the top and the bottom,
+// centered on the point and seven pixels tall.
+void test_text()
+{
+    std::ostringstream stream;
+    jg::png_writer png{stream, {20, 20}, 1};
+    png.write_background("white");
+
+    jg::svg_text_attributes attributes;
+    attributes.font.size = "10";
+    attributes.text_anchor = jg::svg_text_anchor::middle;
+    attributes.dominant_baseline = jg::svg_dominant_baseline::middle;
+    png.write_text({10.5f, 10.5f}, "I", attributes);
+
+    const auto image = png.render();
+    const auto black = [&](int x, int y) { return image.row(y)[x] == jg::rgba{0, 0, 0, 255}; };
+
+    int count = 0;
+
+    for (int y = 0; y < 20; ++y)
+        for (int x = 0; x < 20; ++x)
+            count += black(x, y);
+
+    JG_CHECK(count == 3 + 5 + 3);
+    JG_CHECK(black(9, 7) && black(10, 7) && black(11, 7));
+    JG_CHECK(black(10, 8) && black(10, 12));
+    JG_CHECK(black(9, 13) && black(10, 13) && black(11, 13));
+}
+
+void test_empty_diagram_is_a_valid_image()
+{
+    std::ostringstream stream;
+    jg::diagram{}.write_png(stream);
+
+    const auto decoded = jg::test::png_reader::read(stream.str());
+    JG_CHECK(decoded.has_value() && decoded->width() == 1 && decoded->height() == 1);
+}
+
+void test_scale()
+{
+    std::ostringstream stream;
+    jg::sample_diagram().write_png(stream, 1, 0.5f);
+
+    const auto decoded = jg::test::png_reader::read(stream.str());
+    JG_CHECK(decoded.has_value() && decoded->width() == 450 && decoded->height() == 325);
+}
+
+void test_nothing_is_written_before_finish()
+{
+    std::ostringstream stream;
+    {
+        jg::png_writer png{stream, {10, 10}};
+        png.write_background();
+    }
+
+    JG_CHECK(stream.str().empty());
+}
+
+// The sample diagram against a checked-in reference render. The reference was made by this same
+// rasterizer, so it's a regression golden: it catches changes to the output, not rendering that
+// was wrong all along, which the tests above check against hand-computed pixels. A few channel
+// values of slack absorb floating point differences between compilers.
+void test_sample_matches_reference(const char* reference_path)
+{
+    const auto reference = jg::test::png_reader::read(read_file(reference_path));
+    JG_CHECK(reference.has_value());
+
+    std::ostringstream stream;
+    jg::sample_diagram().write_png(stream);
+    const auto actual = jg::test::png_reader::read(stream.str());
+    JG_CHECK(actual.has_value());
+
+    if (!reference || !actual)
+        return;
+
+    JG_CHECK(actual->width() == reference->width() && actual->height() == reference->height());
+
+    if (actual->width() != reference->width() || actual->height() != reference->height())
+        return;
+
+    int max_difference = 0;
+    int different_pixels = 0;
+
+    for (int y = 0; y < actual->height(); ++y)
+    {
+        for (int x = 0; x < actual->width(); ++x)
+        {
+            const auto a = actual->row(y)[x];
+            const auto r = reference->row(y)[x];
+            const int difference = std::max({std::abs(a.r - r.r), std::abs(a.g - r.g), std::abs(a.b - r.b), std::abs(a.a - r.a)});
+
+            max_difference = std::max(max_difference, difference);
+            different_pixels += difference != 0;
+        }
+    }
+
+    JG_CHECK(max_difference <= 16);
+    JG_CHECK(different_pixels <= actual->width() * actual->height() / 1000);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    if (argc != 2)
+    {
+        std::cerr << "usage: jg_png_writer_test <reference png>\n";
+        return 2;
+    }
+
+    test_round_trip();
+    test_text();
+    test_empty_diagram_is_a_valid_image();
+    test_scale();
+    test_nothing_is_written_before_finish();
+    test_sample_matches_reference(argv[1]);
+
+    return jg::test::report("jg_png_writer_test");
+}
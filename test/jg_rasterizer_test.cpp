@@ -0,0 +1,147 @@
+#include <cstdlib>
+#include "jg_rasterizer.h"
+#include "jg_test.h"
+
+namespace
+{
+
+const jg::rgba black{0, 0, 0, 255};
+
+bool same_pixels(const jg::framebuffer& lhs, const jg::framebuffer& rhs)
+{
+    if (lhs.width() != rhs.width() || lhs.height() != rhs.height())
+        return false;
+
+    for (int y = 0; y < lhs.height(); ++y)
+        for (int x = 0; x < lhs.width(); ++x)
+            if (lhs.row(y)[x] != rhs.row(y)[x])
+                return false;
+
+    return true;
+}
+
+void test_to_rgba()
+{
+    JG_CHECK(jg::to_rgba("#d7eff6") == (jg::rgba{0xd7, 0xef, 0xf6, 255}));
+    JG_CHECK(jg::to_rgba("#fa0") == (jg::rgba{0xff, 0xaa, 0x00, 255}));
+    JG_CHECK(jg::to_rgba("whitesmoke") == (jg::rgba{245, 245, 245, 255}));
+    JG_CHECK(jg::to_rgba("none").a == 0);
+    JG_CHECK(jg::to_rgba("transparent").a == 0);
+}
+
+void test_filled_polygon()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.fill(jg::raster_polygon{{{2, 2}, {10.5f, 2}, {10.5f, 8}, {2, 8}}}, black);
+
+    jg::framebuffer image{16, 16};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(4)[5] == black);
+    JG_CHECK(image.row(4)[1].a == 0);
+    JG_CHECK(image.row(9)[5].a == 0);
+
+    // The right edge splits column 10 in half.
+    JG_CHECK(std::abs(image.row(4)[10].a - 128) <= 8);
+}
+
+void test_ellipse()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.fill(jg::raster_ellipse{{10, 10}, 8, 4}, black);
+
+    jg::framebuffer image{20, 20};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(10)[10] == black);
+    JG_CHECK(image.row(6)[2].a == 0);  // inside the bounds, outside the ellipse
+    JG_CHECK(image.row(15)[10].a == 0);
+}
+
+void test_stroke_leaves_inside_empty()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.stroke_polygon({{4, 4}, {16, 4}, {16, 16}, {4, 16}}, 2, false, black);
+
+    jg::framebuffer image{20, 20};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(4)[10] == black);
+    JG_CHECK(image.row(10)[4] == black);
+    JG_CHECK(image.row(10)[10].a == 0);
+    JG_CHECK(image.row(1)[10].a == 0);
+}
+
+void test_stroke_wider_than_shape()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.stroke_polygon({{10, 10}, {12, 10}, {12, 12}, {10, 12}}, 3, false, black);
+
+    jg::framebuffer image{20, 20};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(10)[10] == black);
+    JG_CHECK(image.row(11)[11] == black);
+}
+
+void test_blending()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.fill(jg::raster_polygon{{{0, 0}, {4, 0}, {4, 4}, {0, 4}}}, {255, 255, 255, 255});
+    rasterizer.fill(jg::raster_polygon{{{0, 0}, {4, 0}, {4, 4}, {0, 4}}}, {0, 0, 0, 128});
+
+    jg::framebuffer image{4, 4};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(1)[1].a == 255);
+    JG_CHECK(std::abs(image.row(1)[1].r - 127) <= 1);
+}
+
+void test_bands_match_single_thread()
+{
+    jg::rasterizer rasterizer;
+    rasterizer.fill(jg::raster_ellipse{{50, 40}, 45, 35}, {215, 239, 246, 255});
+    rasterizer.stroke_ellipse({50, 40}, 45, 35, 3, black);
+    rasterizer.stroke_line({0, 0}, {100, 80}, 3, black);
+
+    jg::framebuffer single{100, 80};
+    rasterizer.render(single, 1);
+
+    for (unsigned threads : {2u, 3u, 7u, 200u})
+    {
+        jg::framebuffer banded{100, 80};
+        rasterizer.render(banded, threads);
+        JG_CHECK(same_pixels(single, banded));
+    }
+}
+
+void test_translated_symbol()
+{
+    jg::rasterizer symbol;
+    symbol.fill(jg::raster_polygon{{{0, 0}, {4, 0}, {4, 4}, {0, 4}}}, black);
+
+    jg::rasterizer rasterizer;
+    rasterizer.draw(symbol, {10, 6});
+
+    jg::framebuffer image{20, 20};
+    rasterizer.render(image, 1);
+
+    JG_CHECK(image.row(7)[11] == black);
+    JG_CHECK(image.row(1)[1].a == 0);
+}
+
+} // namespace
+
+int main()
+{
+    test_to_rgba();
+    test_filled_polygon();
+    test_ellipse();
+    test_stroke_leaves_inside_empty();
+    test_stroke_wider_than_shape();
+    test_blending();
+    test_bands_match_single_thread();
+    test_translated_symbol();
+
+    return jg::test::report("jg_rasterizer_test");
+}
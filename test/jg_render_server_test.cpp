@@ -0,0 +1,160 @@
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "jg_render_server.h"
+#include "jg_test.h"
+
+namespace
+{
+
+std::string request(std::string_view description)
+{
+    return std::to_string(description.size()) + "\n" + std::string{description};
+}
+
+// The status ("ok" or "error") and body of every response, in order.
+std::vector<std::pair<std::string, std::string>> serve(const std::string& requests, unsigned thread_count)
+{
+    std::istringstream input{requests};
+    std::ostringstream output;
+    jg::render_server{input, output, thread_count}.run();
+
+    std::istringstream responses{output.str()};
+    std::vector<std::pair<std::string, std::string>> result;
+    std::string status;
+    size_t size{};
+
+    while (responses >> status >> size && responses.get() == '\n')
+    {
+        std::string body(size, '\0');
+        responses.read(body.data(), static_cast<std::streamsize>(size));
+        result.emplace_back(status, body);
+    }
+
+    return result;
+}
+
+// Requests that used to crash the server are answered with errors, and the server goes on.
+void test_bad_requests_dont_stop_the_server()
+{
+    const std::string good = "rectangle 0 0 100 100 A\nellipse 200 0 100 100 B\narrow 0 1\n";
+
+    for (unsigned threads : {1u, 4u})
+    {
+        const auto responses = serve(request(good) +
+                                     request("rectangle 0 0 100 100 A\narrow 0 0\n") +
+                                     request("rectangle 1e30 0 100 100 A\n") +
+                                     request("bogus 1 2 3 4\n") +
+                                     request("rectangle 0 0 -5 10 A\n") +
+                                     request(good), threads);
+
+        JG_CHECK(responses.size() == 6);
+
+        if (responses.size() != 6)
+            continue;
+
+        JG_CHECK(responses[0].first == "ok" && responses[0].second.find("<svg ") == 0);
+        JG_CHECK(responses[1] == std::make_pair(std::string{"error"}, std::string{"line 2: arrow must connect two different shapes"}));
+        JG_CHECK(responses[2] == std::make_pair(std::string{"error"}, std::string{"line 1: bounds must lie within +-1000000"}));
+        JG_CHECK(responses[3] == std::make_pair(std::string{"error"}, std::string{"line 1: unknown item 'bogus'"}));
+        JG_CHECK(responses[4] == std::make_pair(std::string{"error"}, std::string{"line 1: width and height must not be negative"}));
+        JG_CHECK(responses[5] == responses[0]);
+    }
+}
+
+void test_responses_come_in_request_order()
+{
+    std::string requests;
+
+    for (int i = 0; i < 50; ++i)
+        requests += request("title diagram " + std::to_string(i) + "\nrectangle " + std::to_string(i * 10) + " 0 100 100 A\n");
+
+    const auto responses = serve(requests, 4);
+    JG_CHECK(responses.size() == 50);
+
+    for (size_t i = 0; i < responses.size(); ++i)
+        JG_CHECK(responses[i].second.find(">diagram " + std::to_string(i) + "</text>") != std::string::npos);
+}
+
+void test_invalid_header_ends_the_session()
+{
+    const auto responses = serve(request("rectangle 0 0 100 100 A\n") + "abc\n" + request("rectangle 0 0 100 100 A\n"), 2);
+
+    JG_CHECK(responses.size() == 2);
+    JG_CHECK(responses.size() == 2 && responses[1] == std::make_pair(std::string{"error"}, std::string{"invalid request header 'abc'"}));
+}
+
+// Titles and labels come from the client, so they mustn't be able to end their elements.
+void test_text_is_escaped()
+{
+    const auto responses = serve(request("title a</text><script>x</script>\nrectangle 0 0 100 100 a--b<&\n"), 2);
+
+    JG_CHECK(responses.size() == 1);
+
+    if (responses.size() != 1)
+        return;
+
+    const auto& svg = responses[0].second;
+    JG_CHECK(responses[0].first == "ok");
+    JG_CHECK(svg.find("<script") == std::string::npos);
+    JG_CHECK(svg.find(">a&lt;/text&gt;&lt;script&gt;x&lt;/script&gt;</text>") != std::string::npos);
+    JG_CHECK(svg.find(">a--b&lt;&amp;</text>") != std::string::npos);
+
+    // The label's comment, which mustn't contain "--" before its end.
+    const auto comment = svg.find("<!--a");
+    JG_CHECK(comment != std::string::npos);
+
+    if (comment != std::string::npos)
+    {
+        const auto end = svg.find(" /-->", comment);
+        JG_CHECK(svg.substr(comment + 4, end - comment - 4) == "a-b<&");
+    }
+}
+
+// An oversized request is skipped over, without reading it into memory, and the session goes on.
+void test_oversized_request_is_skipped()
+{
+    const std::string oversized(jg::render_server::max_request_size + 1, 'x');
+    const auto responses = serve(request(oversized) + request("rectangle 0 0 100 100 A\n"), 2);
+
+    JG_CHECK(responses.size() == 2);
+
+    if (responses.size() != 2)
+        return;
+
+    JG_CHECK(responses[0] == std::make_pair(std::string{"error"}, "request of " + std::to_string(oversized.size()) + " bytes exceeds the maximum of " + std::to_string(jg::render_server::max_request_size)));
+    JG_CHECK(responses[1].first == "ok");
+}
+
+// Like std::cin and std::cout: the tie would flush the output from the reading thread, racing
+// with the workers writing responses.
+void test_tied_output_isnt_flushed_while_reading()
+{
+    std::string requests;
+
+    for (int i = 0; i < 20; ++i)
+        requests += request("rectangle 0 0 100 100 A\n");
+
+    std::istringstream input{requests};
+    std::ostringstream output;
+    input.tie(&output);
+    jg::render_server{input, output, 4}.run();
+
+    JG_CHECK(input.tie() == nullptr);
+    JG_CHECK(output.str().find("ok ") == 0);
+}
+
+} // namespace
+
+int main()
+{
+    test_bad_requests_dont_stop_the_server();
+    test_responses_come_in_request_order();
+    test_invalid_header_ends_the_session();
+    test_text_is_escaped();
+    test_oversized_request_is_skipped();
+    test_tied_output_isnt_flushed_while_reading();
+
+    return jg::test::report("jg_render_server_test");
+}
@@ -0,0 +1,88 @@
+#include <cstdint>
+#include <limits>
+#include <string>
+#include "jg_svg_path.h"
+#include "jg_test.h"
+
+namespace
+{
+
+void test_number_format()
+{
+    const jg::svg_number_format format;
+
+    JG_CHECK(format.to_string(0) == "0");
+    JG_CHECK(format.to_string(25) == "25");
+    JG_CHECK(format.to_string(0.5f) == ".5");
+    JG_CHECK(format.to_string(.05f) == ".05");
+    JG_CHECK(format.to_string(-1.25f) == "-1.25");
+    JG_CHECK(format.to_string(1.234f) == "1.23");
+    JG_CHECK(format.to_string(-0.004f) == "0");
+    JG_CHECK(format.to_string(-0.0f) == "0");
+
+    JG_CHECK(jg::svg_number_format{0}.to_string(2.5f) == "3");
+    JG_CHECK(jg::svg_number_format{4}.to_string(0.0625f) == ".0625");
+}
+
+void test_number_format_out_of_range()
+{
+    const jg::svg_number_format format;
+
+    JG_CHECK(format.to_string(std::numeric_limits<float>::quiet_NaN()) == "nan");
+    JG_CHECK(format.to_string(std::numeric_limits<float>::infinity()) == "inf");
+    JG_CHECK(format.to_string(-std::numeric_limits<float>::infinity()) == "-inf");
+    JG_CHECK(format.to_string(1e30f) == "1e+30");
+    JG_CHECK(format.to_string(-1e30f) == "-1e+30");
+    JG_CHECK(format.to_string(std::numeric_limits<float>::max()) == "3.40282e+38");
+
+    JG_CHECK(format.quantize(std::numeric_limits<float>::quiet_NaN()) == 0);
+    JG_CHECK(format.quantize(std::numeric_limits<float>::infinity()) == jg::svg_number_format::max_units);
+    JG_CHECK(format.quantize(-1e30f) == -jg::svg_number_format::max_units);
+
+    std::string text;
+    format.append_units(text, std::numeric_limits<std::int64_t>::min());
+    JG_CHECK(text == "-92233720368547758.08");
+}
+
+void test_path()
+{
+    const jg::svg_number_format format;
+    jg::svg_path path{format};
+
+    path.move_to({10, 10}).line_to({20, 10}).line_to({20, 25.5f}).line_to({10, 30}).close();
+    JG_CHECK(path.str() == "M10 10h10v15.5l-10 4.5z");
+
+    path.clear();
+    path.move_to({0, 0}).line_to({.5f, .25f}).line_to({1, 1});
+    JG_CHECK(path.str() == "M0 0l.5.25.5.75");
+
+    path.clear();
+    path.move_to({0, 0}).line_to({5, 5}).close().move_to({10, 10}).line_to({15, 15});
+    JG_CHECK(path.str() == "M0 0l5 5zm10 10 5 5");  // relative linetos are implicit after m
+
+    path.clear();
+    path.point({0, 0}).point({20, 10}).point({0, 20});
+    JG_CHECK(path.str() == "0 0 20 10 0 20");
+}
+
+// Out of range coordinates are clamped rather than overflowing the relative offsets.
+void test_path_out_of_range()
+{
+    const jg::svg_number_format format;
+    jg::svg_path path{format};
+
+    path.move_to({1e30f, 0}).line_to({-1e30f, std::numeric_limits<float>::quiet_NaN()});
+    JG_CHECK(path.str() == "M90071992547409.92 0h-180143985094819.84");
+}
+
+} // namespace
+
+int main()
+{
+    test_number_format();
+    test_number_format_out_of_range();
+    test_path();
+    test_path_out_of_range();
+
+    return jg::test::report("jg_svg_path_test");
+}
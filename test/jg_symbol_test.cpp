@@ -0,0 +1,312 @@
+#include <algorithm>
+#include <cstdlib>
+#include <set>
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <variant>
+#include <vector>
+#include "jg_png_reader.h"
+#include "jg_png_writer.h"
+#include "jg_sample_diagram.h"
+#include "jg_test.h"
+
+namespace
+{
+
+// The shapes of the sample diagram, on their own.
+std::vector<jg::diagram::shapes> sample_shapes()
+{
+    return
+    {
+        jg::rectangle    {{ 50, 100, 300, 100}, "Rectangle"},
+        jg::ellipse      {{500,  50, 300, 100}, "Ellipse"},
+        jg::rhombus      {{550, 500, 300, 100}, "Rhombus"},
+        jg::parallelogram{{ 50, 500, 400, 100}, "Parallelogram"},
+        jg::circle       {{200, 250, 150, 150}, "Circle"}
+    };
+}
+
+// Forwards to a writer, but ignores what the symbols are made of. Instead, every use of a shape
+// symbol draws the next of the expected shapes in place, from its absolute bounds, and every use
+// of an anchor symbol draws markers at that shape's anchors(). That's the geometry the diagram
+// should show, worked out without its symbols.
+template <typename TWriter>
+class reference_writer final
+{
+public:
+    reference_writer(TWriter& writer, std::vector<jg::diagram::shapes> shapes)
+        : m_writer{writer}
+        , m_shapes{std::move(shapes)}
+    {}
+
+    void write_background(std::string_view color = "white") { m_writer.write_background(color); }
+    void write_grid(float distance, std::string_view color = "whitesmoke") { m_writer.write_grid(distance, color); }
+    void write_title(std::string_view title) { m_writer.write_title(title); }
+    void write_border() { m_writer.write_border(); }
+    void write_comment(std::string_view comment) { m_writer.write_comment(comment); }
+
+    void write_line(jg::point point1, jg::point point2, const jg::svg_paint_attributes& attributes)
+    {
+        m_writer.write_line(point1, point2, attributes);
+    }
+
+    void write_arrow(jg::point point1, jg::point point2, const jg::svg_paint_attributes& attributes)
+    {
+        m_writer.write_arrow(point1, point2, attributes);
+    }
+
+    void write_text(jg::point point, std::string_view text, const jg::svg_text_attributes& attributes)
+    {
+        m_writer.write_text(point, text, attributes);
+    }
+
+    // Symbols only have shapes in them, and those are drawn on use.
+    void write_rect(jg::rect, const jg::svg_paint_attributes&) { JG_CHECK(m_in_symbol); }
+    void write_rhombus(jg::rect, const jg::svg_paint_attributes&) { JG_CHECK(m_in_symbol); }
+    void write_parallelogram(jg::rect, const jg::svg_paint_attributes&) { JG_CHECK(m_in_symbol); }
+    void write_circle(jg::point, float, const jg::svg_paint_attributes&) { JG_CHECK(m_in_symbol); }
+    void write_ellipse(jg::point, float, float, const jg::svg_paint_attributes&) { JG_CHECK(m_in_symbol); }
+
+    const jg::svg_number_format& number_format() const
+    {
+        return m_writer.number_format();
+    }
+
+    void begin_symbol(std::string_view)
+    {
+        m_in_symbol = true;
+    }
+
+    void end_symbol()
+    {
+        m_in_symbol = false;
+    }
+
+    void write_use(std::string_view id, jg::point point)
+    {
+        if (id.substr(0, 5) == "shape")
+        {
+            JG_CHECK(m_next < m_shapes.size());
+
+            if (m_next == m_shapes.size())
+                return;
+
+            m_current = &m_shapes[m_next++];
+        }
+
+        JG_CHECK(m_current != nullptr);
+
+        if (!m_current)
+            return;
+
+        const jg::svg_paint_attributes paint{"#d7eff6", "black", "3"};
+
+        std::visit([&](const auto& shape)
+        {
+            const auto bounds = shape.bounds();
+            JG_CHECK(point.x == bounds.x && point.y == bounds.y);
+
+            if (id.substr(0, 7) == "anchors")
+            {
+                for (const auto& anchor : shape.anchors())
+                    m_writer.write_circle(anchor, 5, {"red", "none", "1"});
+
+                return;
+            }
+
+            using shape_type = std::decay_t<decltype(shape)>;
+
+            if constexpr (std::is_same_v<shape_type, jg::rectangle>)
+                m_writer.write_rect(bounds, paint);
+            else if constexpr (std::is_same_v<shape_type, jg::rhombus>)
+                m_writer.write_rhombus(bounds, paint);
+            else if constexpr (std::is_same_v<shape_type, jg::parallelogram>)
+                m_writer.write_parallelogram(bounds, paint);
+            else if constexpr (std::is_same_v<shape_type, jg::ellipse>)
+                m_writer.write_ellipse({bounds.x + bounds.width / 2, bounds.y + bounds.height / 2}, bounds.width / 2, bounds.height / 2, paint);
+            else
+            {
+                const float radius = std::min(bounds.width, bounds.height) / 2;
+                m_writer.write_circle({bounds.x + radius, bounds.y + radius}, radius, paint);
+            }
+        }, *m_current);
+    }
+
+    bool all_drawn() const
+    {
+        return m_next == m_shapes.size();
+    }
+
+private:
+    TWriter& m_writer;
+    std::vector<jg::diagram::shapes> m_shapes;
+    size_t m_next{};
+    const jg::diagram::shapes* m_current{};
+    bool m_in_symbol{};
+};
+
+std::string svg(const jg::diagram& diagram, float scale = 1)
+{
+    std::ostringstream stream;
+    diagram.write_svg(stream, scale);
+    return stream.str();
+}
+
+// The values of every attribute with the given name, in document order.
+std::vector<std::string> attribute_values(const std::string& text, const std::string& tag, const std::string& attribute)
+{
+    std::vector<std::string> values;
+    const auto tag_start = "<" + tag + " ";
+    const auto attribute_start = " " + attribute + "=\"";
+
+    for (auto pos = text.find(tag_start); pos != std::string::npos; pos = text.find(tag_start, pos + 1))
+    {
+        const auto end = text.find('>', pos);
+        const auto value = text.find(attribute_start, pos);
+
+        if (value == std::string::npos || value > end)
+        {
+            values.emplace_back();
+            continue;
+        }
+
+        const auto value_start = value + attribute_start.size();
+        values.push_back(text.substr(value_start, text.find('"', value_start) - value_start));
+    }
+
+    return values;
+}
+
+size_t count(const std::string& text, const std::string& pattern)
+{
+    size_t result = 0;
+
+    for (auto pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1))
+        ++result;
+
+    return result;
+}
+
+// Every use refers to a symbol defined before it.
+bool uses_resolve(const std::string& text)
+{
+    std::set<std::string> defined;
+    size_t pos = 0;
+
+    while (true)
+    {
+        const auto symbol = text.find("<symbol ", pos);
+        const auto use = text.find("<use ", pos);
+
+        if (use == std::string::npos)
+            return true;
+
+        if (symbol < use)
+        {
+            defined.insert(attribute_values(text.substr(symbol, text.find('>', symbol) - symbol + 1), "symbol", "id").front());
+            pos = symbol + 1;
+            continue;
+        }
+
+        const auto href = attribute_values(text.substr(use, text.find('>', use) - use + 1), "use", "xlink:href").front();
+
+        if (href.empty() || href[0] != '#' || defined.count(href.substr(1)) == 0)
+            return false;
+
+        pos = use + 1;
+    }
+}
+
+void test_instanced_png_matches_reference_geometry()
+{
+    const auto diagram = jg::sample_diagram();
+
+    std::ostringstream instanced_stream;
+    diagram.write_png(instanced_stream);
+    const auto instanced = jg::test::png_reader::read(instanced_stream.str());
+
+    JG_CHECK(instanced.has_value());
+
+    if (!instanced)
+        return;
+
+    std::ostringstream reference_stream;
+    jg::png_writer png{reference_stream, {static_cast<float>(instanced->width()), static_cast<float>(instanced->height())}};
+    reference_writer<jg::png_writer> reference{png, sample_shapes()};
+    diagram.write(reference, 1);
+    JG_CHECK(reference.all_drawn());
+
+    const auto expected = png.render();
+
+    // Moving a shape after building its outline may round differently from building it in place.
+    int max_difference = 0;
+
+    for (int y = 0; y < expected.height(); ++y)
+    {
+        for (int x = 0; x < expected.width(); ++x)
+        {
+            const auto a = instanced->row(y)[x];
+            const auto e = expected.row(y)[x];
+            max_difference = std::max({max_difference, std::abs(a.r - e.r), std::abs(a.g - e.g), std::abs(a.b - e.b), std::abs(a.a - e.a)});
+        }
+    }
+
+    JG_CHECK(max_difference <= 2);
+}
+
+void test_svg_symbol_structure()
+{
+    const auto text = svg(jg::sample_diagram());
+
+    JG_CHECK(text.find("xmlns:xlink=\"http://www.w3.org/1999/xlink\"") != std::string::npos);
+    JG_CHECK(uses_resolve(text));
+
+    // A symbol for each of the five shapes, and one for each distinct set of anchors: the
+    // rectangle, ellipse and rhombus are the same size and have the same anchors.
+    const auto overflows = attribute_values(text, "symbol", "overflow");
+    JG_CHECK(overflows.size() == 8);
+    JG_CHECK(std::all_of(overflows.begin(), overflows.end(), [](const auto& value) { return value == "visible"; }));
+    JG_CHECK(count(text, "xlink:href=\"#anchors0\"") == 3);
+
+    // A shape and its anchor markers for each of the five shapes.
+    JG_CHECK(count(text, "<use ") == 10);
+    JG_CHECK(count(text, "<rect ") == 3);  // the background, the rectangle's symbol and the border
+}
+
+void test_shapes_of_equal_size_share_a_symbol()
+{
+    jg::diagram diagram{"shared"};
+    diagram.add_item(jg::rectangle{{50, 50, 100, 60}, "A"});
+    diagram.add_item(jg::rectangle{{250, 50, 100, 60}, "B"});
+    diagram.add_item(jg::rectangle{{450, 50, 120, 60}, "C"});
+
+    const auto text = svg(diagram);
+
+    JG_CHECK(uses_resolve(text));
+    JG_CHECK(count(text, "<symbol ") == 4);
+    JG_CHECK(count(text, "xlink:href=\"#shape0\"") == 2);
+    JG_CHECK(count(text, "xlink:href=\"#shape1\"") == 1);
+}
+
+void test_zoomed_out_uses_resolve()
+{
+    const auto text = svg(jg::sample_diagram(), 0.1f);
+
+    // Anchor markers are too small at this scale, so only the shapes are left.
+    JG_CHECK(uses_resolve(text));
+    JG_CHECK(count(text, "<symbol ") == 5);
+    JG_CHECK(count(text, "<use ") == 5);
+}
+
+} // namespace
+
+int main()
+{
+    test_instanced_png_matches_reference_geometry();
+    test_svg_symbol_structure();
+    test_shapes_of_equal_size_share_a_symbol();
+    test_zoomed_out_uses_resolve();
+
+    return jg::test::report("jg_symbol_test");
+}
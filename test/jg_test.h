@@ -0,0 +1,38 @@
+#pragma once
+
+#include <iostream>
+
+namespace jg::test
+{
+
+int& failure_count()
+{
+    static int count;
+    return count;
+}
+
+void check(bool condition, const char* expression, const char* file, int line)
+{
+    if (condition)
+        return;
+
+    ++failure_count();
+    std::cerr << file << "(" << line << "): check failed: " << expression << "\n";
+}
+
+// The exit code of a test executable.
+int report(const char* name)
+{
+    if (failure_count() == 0)
+    {
+        std::cout << name << ": all checks passed\n";
+        return 0;
+    }
+
+    std::cerr << name << ": " << failure_count() << " check(s) failed\n";
+    return 1;
+}
+
+} // namespace jg::test
+
+#define JG_CHECK(expression) jg::test::check((expression), #expression, __FILE__, __LINE__)